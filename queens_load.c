@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+const char *socket_path = "/tmp/queens.sock";
+int num_clients = 4;  // Concurrent connections
+int requests_per_client = 100;  // Requests sent on each connection
+int min_n = 4;  // Smallest board size requested
+int max_n = 10;  // Largest board size requested
+const char *mode = "count";  // count, enum or verify
+long long enum_limit = 0;  // LIMIT sent with ENUM requests (0 = all solutions)
+
+double *latencies;  // requests_per_client slots per client, filled with completed requests only
+int *completed;  // Completed requests per client
+int failed_requests = 0;
+pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Get the current wall-clock time in seconds
+ */
+double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Connect to the solver daemon
+ * Returns the socket, or -1 on failure
+ */
+int connect_to_server(void) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Build one solution directly (even columns then odd columns, adjusted when
+ * N mod 6 is 2 or 3) so VERIFY requests always carry a valid placement
+ */
+void construct_solution(int *b, int size) {
+    int row = 0;
+    int rem = size % 6;
+
+    if (size == 1) {
+        b[0] = 0;
+        return;
+    }
+    if (rem == 3) {
+        for (int col = 4; col <= size; col += 2) {
+            b[row++] = col - 1;
+        }
+        b[row++] = 1;
+    } else {
+        for (int col = 2; col <= size; col += 2) {
+            b[row++] = col - 1;
+        }
+    }
+    if (rem == 2) {
+        b[row++] = 2;
+        b[row++] = 0;
+        for (int col = 7; col <= size; col += 2) {
+            b[row++] = col - 1;
+        }
+        b[row++] = 4;
+    } else if (rem == 3) {
+        for (int col = 5; col <= size; col += 2) {
+            b[row++] = col - 1;
+        }
+        b[row++] = 0;
+        b[row++] = 2;
+    } else {
+        for (int col = 1; col <= size; col += 2) {
+            b[row++] = col - 1;
+        }
+    }
+}
+
+/**
+ * Client thread: send requests back to back on one connection and record the latency
+ * of each request that completes (failed requests are only counted)
+ */
+void *client_worker(void *arg) {
+    int client = (int)(long)arg;
+    unsigned int seed = (unsigned int)(time(NULL) ^ (client * 7919));
+    double *my_latencies = &latencies[client * requests_per_client];
+
+    int fd = connect_to_server();
+    if (fd < 0) {
+        pthread_mutex_lock(&stats_mutex);
+        failed_requests += requests_per_client;
+        pthread_mutex_unlock(&stats_mutex);
+        return NULL;
+    }
+    FILE *in = fdopen(dup(fd), "r");
+    char *line = NULL;
+    size_t line_capacity = 0;
+    int *placement = (int *)malloc(max_n * sizeof(int));
+    char *request = (char *)malloc(32 + 12 * max_n);
+    int failures = 0;
+
+    for (int r = 0; r < requests_per_client; r++) {
+        int size = min_n + rand_r(&seed) % (max_n - min_n + 1);
+        int len;
+        if (strcmp(mode, "enum") == 0) {
+            len = sprintf(request, "ENUM %d %lld\n", size, enum_limit);
+        } else if (strcmp(mode, "verify") == 0) {
+            // No solutions exist for 2 and 3, so those send an (invalid) identity placement
+            for (int row = 0; row < size; row++) {
+                placement[row] = row;
+            }
+            if (size == 1 || size >= 4) {
+                construct_solution(placement, size);
+            }
+            len = sprintf(request, "VERIFY");
+            for (int row = 0; row < size; row++) {
+                len += sprintf(request + len, " %d", placement[row]);
+            }
+            request[len++] = '\n';
+        } else {
+            len = sprintf(request, "COUNT %d\n", size);
+        }
+
+        double start = wall_time();
+        if (write(fd, request, len) != len) {
+            failures += requests_per_client - r;
+            break;
+        }
+
+        // Read until the line that ends this request (ENUM streams SOL lines first)
+        int ok = 0;
+        int answered = 0;
+        while (getline(&line, &line_capacity, in) > 0) {
+            if (strncmp(line, "SOL ", 4) == 0) {
+                continue;
+            }
+            ok = (strncmp(line, "ERR", 3) != 0);
+            answered = 1;
+            break;
+        }
+        if (!answered) {
+            failures += requests_per_client - r;  // Server closed the connection
+            break;
+        }
+        if (ok) {
+            my_latencies[completed[client]++] = wall_time() - start;
+        } else {
+            failures++;
+        }
+    }
+
+    if (write(fd, "QUIT\n", 5) != 5) {
+        // Best effort only: the server treats the close below as a disconnect anyway
+    }
+    free(request);
+    free(placement);
+    free(line);
+    if (in) {
+        fclose(in);
+    }
+    close(fd);
+
+    pthread_mutex_lock(&stats_mutex);
+    failed_requests += failures;
+    pthread_mutex_unlock(&stats_mutex);
+    return NULL;
+}
+
+/**
+ * Compare two latencies for qsort
+ */
+int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Print usage information
+ */
+void print_usage(const char *program_name) {
+    printf("Usage: %s [OPTIONS]\n\n", program_name);
+    printf("Load generator for the N-Queens solver daemon (queens_mt --serve).\n\n");
+    printf("OPTIONS:\n");
+    printf("  --socket PATH      Daemon socket (default: /tmp/queens.sock)\n");
+    printf("  --clients NUM      Concurrent connections (default: 4)\n");
+    printf("  --requests NUM     Requests per connection (default: 100)\n");
+    printf("  --sizes LO-HI      Range of board sizes to request (default: 4-10)\n");
+    printf("  --mode MODE        count, enum or verify (default: count)\n");
+    printf("  --limit K          LIMIT sent with enum requests (default: all solutions)\n");
+    printf("  --help             Show this help message\n\n");
+    printf("EXAMPLES:\n");
+    printf("  %s --clients 8 --requests 1000           # Latency of cached COUNT requests\n", program_name);
+    printf("  %s --mode enum --sizes 6-9 --limit 10    # Streamed enumeration\n", program_name);
+}
+
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (i + 1 >= argc) {
+            fprintf(stderr, "Error: Unknown option or missing argument '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        } else if (strcmp(argv[i], "--socket") == 0) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--clients") == 0) {
+            num_clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--requests") == 0) {
+            requests_per_client = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sizes") == 0) {
+            if (sscanf(argv[++i], "%d-%d", &min_n, &max_n) == 1) {
+                max_n = min_n;
+            }
+        } else if (strcmp(argv[i], "--mode") == 0) {
+            mode = argv[++i];
+        } else if (strcmp(argv[i], "--limit") == 0) {
+            enum_limit = atoll(argv[++i]);
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (num_clients < 1 || requests_per_client < 1 || min_n < 1 || max_n < min_n || enum_limit < 0) {
+        fprintf(stderr, "Error: Clients, requests and sizes must be positive (LO <= HI)\n");
+        return 1;
+    }
+    if (strcmp(mode, "count") != 0 && strcmp(mode, "enum") != 0 && strcmp(mode, "verify") != 0) {
+        fprintf(stderr, "Error: Mode must be count, enum or verify\n");
+        return 1;
+    }
+
+    int total_requests = num_clients * requests_per_client;
+    latencies = (double *)calloc(total_requests, sizeof(double));
+    completed = (int *)calloc(num_clients, sizeof(int));
+    signal(SIGPIPE, SIG_IGN);  // A server that goes away fails the request instead of killing us
+    pthread_t *threads = (pthread_t *)malloc(num_clients * sizeof(pthread_t));
+
+    double start = wall_time();
+    for (int i = 0; i < num_clients; i++) {
+        pthread_create(&threads[i], NULL, client_worker, (void *)(long)i);
+    }
+    for (int i = 0; i < num_clients; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = wall_time() - start;
+
+    // Gather the completed requests' latencies at the front of the array
+    int total_completed = 0;
+    for (int i = 0; i < num_clients; i++) {
+        memmove(&latencies[total_completed], &latencies[i * requests_per_client],
+                completed[i] * sizeof(double));
+        total_completed += completed[i];
+    }
+    qsort(latencies, total_completed, sizeof(double), compare_doubles);
+    double sum = 0.0;
+    for (int i = 0; i < total_completed; i++) {
+        sum += latencies[i];
+    }
+
+    printf("╔════════════════════════════════════════════════════════════╗\n");
+    printf("║  LOAD TEST: %-6s N=%d-%-3d %3d client(s) x %-6d request(s) ║\n",
+           mode, min_n, max_n, num_clients, requests_per_client);
+    printf("╚════════════════════════════════════════════════════════════╝\n\n");
+    printf("Time: %.6f seconds | Failed requests: %d\n", elapsed, failed_requests);
+    printf("Throughput: %.1f completed requests/second\n", total_completed / elapsed);
+    if (total_completed > 0) {
+        printf("Latency (microseconds): mean %.1f | p50 %.1f | p95 %.1f | p99 %.1f | max %.1f\n",
+               sum / total_completed * 1e6,
+               latencies[total_completed / 2] * 1e6,
+               latencies[(int)(total_completed * 0.95)] * 1e6,
+               latencies[(int)(total_completed * 0.99)] * 1e6,
+               latencies[total_completed - 1] * 1e6);
+    } else {
+        printf("Latency: no request completed\n");
+    }
+
+    free(threads);
+    free(completed);
+    free(latencies);
+    return failed_requests > 0 ? 1 : 0;
+}
@@ -4,6 +4,13 @@
 #include <time.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 int n;
 __thread int *board;
@@ -14,7 +21,14 @@ int num_threads = 0;  // User-specified thread count (0 = auto-detect)
 int print_solutions = 1;  // 1 = print solutions, 0 = quiet mode
 int show_progress = 0;  // 1 = show progress, 0 = no progress
 int work_completed = 0;  // Track completed work items
-int total_work_items = 0;  // Total work items to process
+int total_work_items = 0;  // Work items produced so far (final once the producer finishes)
+int queue_size = 0;  // Bounded queue capacity (0 = auto)
+double start_wall = 0.0;  // Wall-clock time the solve started
+double first_solution_wall = -1.0;  // Wall-clock time of the first solution (-1 = none yet)
+int solution_limit = 0;  // Stop after this many solutions (0 = no limit)
+int unique_limit = 0;  // Stop after this many unique solutions (0 = no limit)
+int use_construct = 0;  // 1 = build one solution directly instead of searching
+int stop_search = 0;  // Set once a limit is reached; every thread winds down cooperatively
 
 // Forward declarations
 int is_safe_with_board(int row, int col, int *b);
@@ -25,22 +39,139 @@ pthread_mutex_t print_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t data_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t progress_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Mutex and condition variables for the bounded work queue
+pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
+pthread_cond_t queue_not_full = PTHREAD_COND_INITIALIZER;
+
+// One board size in batch or server mode; its work items share the pool with every other job
+typedef struct {
+    int n;
+    int depth;               // Parallelization depth for this size
+    long long solutions;
+    long long uniques;
+    int work_items;
+    int pending;             // Outstanding items, plus one while the producer is still emitting
+    double end_wall;         // Wall-clock time the last item for this size finished
+    int out_fd;              // Stream each solution to this socket (-1 = count only)
+    char *out_buffer;        // SOL lines queued by the workers for the client thread to send
+    size_t out_length;
+    size_t out_capacity;
+    char *send_buffer;       // Batch the client thread is currently sending (swapped with out_buffer)
+    size_t send_capacity;
+    long long limit;         // Stop streaming after this many solutions (0 = no limit)
+    int stopped;             // Set once the limit is reached or the job is cancelled
+    int cancelled;           // Set when the client hung up or the server is shutting down
+    int client_fd;           // Requesting client, watched for hangups (-1 = none)
+    int priority;            // Queue items on the priority lane (small server jobs)
+    pthread_mutex_t out_mutex;  // Guards out_buffer and the streamed counts
+} BatchJob;
+
 // Thread work structure - represents a partial board state to solve from
 typedef struct {
-    int *board;  // Partial board configuration
-    int depth;   // Starting depth (which row to start solving from)
+    int *board;     // Partial board configuration
+    int depth;      // Starting depth (which row to start solving from)
+    BatchJob *job;  // Owning batch/server job (NULL for the single-size solve)
 } WorkItem;
 
-// Work queue for distributing partial solutions
+// Bounded work queue (ring buffer) fed by the producer while workers consume
 typedef struct {
-    WorkItem *items;
+    WorkItem *items;  // Ring buffer slots
+    int *storage;     // Backing store for the slot boards (capacity * n ints)
     int capacity;
-    int size;
+    int head;         // Next slot to consume
+    int tail;         // Next slot to fill
+    int count;        // Items currently queued
+    int closed;       // 1 once the producer has finished
 } WorkQueue;
 
 WorkQueue work_queue;
+WorkQueue priority_queue;  // Batch and server: items of small jobs, taken before work_queue
 int parallelization_depth = 0;
 
+#define MAX_BATCH_N 64       // Largest size --batch accepts
+#define BATCH_PRIORITY_GAP 2  // Batch sizes at least this far below the largest are produced alongside it
+
+BatchJob *batch_jobs = NULL;
+int num_batch_jobs = 0;
+int batch_jobs_capacity = 0;
+__thread int *scratch;  // Per-thread buffer for symmetry checks in batch mode
+
+void solve_batch_item(BatchJob *job, int depth);
+
+// Server mode: warm pool plus a count cache shared by every client connection
+#define MAX_SERVER_N 32
+#define SERVER_PRIORITY_N 12  // Jobs up to this size skip ahead of larger ones
+#define SERVER_ITEM_ROWS 12   // Rows left for a worker to solve in one server item
+#define SERVER_OUT_FLUSH (64 << 10)  // Buffered SOL bytes that wake the client thread early
+#define SERVER_OUT_LIMIT (4 << 20)   // Buffered SOL bytes after which a non-reading client's job is cancelled
+
+typedef struct {
+    long long solutions;
+    long long uniques;
+    int valid;
+} CachedCount;
+
+CachedCount count_cache[MAX_SERVER_N + 1];
+pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+volatile sig_atomic_t server_running = 1;
+long requests_served = 0;
+long cache_hits = 0;
+const char *serve_path = NULL;  // Unix socket to listen on (NULL = not in server mode)
+int *client_fds = NULL;  // Sockets of the connected clients, so shutdown can wake them
+int num_client_fds = 0;
+int client_fds_capacity = 0;
+pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t clients_changed = PTHREAD_COND_INITIALIZER;
+
+// Canonicalizer mode: records flow from the reader to the workers through a fixed pool of batches
+#define MAX_RECORD_N 255
+#define RECORD_BATCH_SIZE 4096
+#define CLASS_SHARDS 64
+#define VERIFY_WORDS(size) ((2 * (size) + 63) / 64)
+
+typedef struct {
+    unsigned char *cells;  // RECORD_BATCH_SIZE records of MAX_RECORD_N columns each
+    int *sizes;            // Board size of each record (-1 = malformed)
+    long first_record;     // Index of the first record in the stream
+    long *lines;           // Source line of each record (text input only)
+    int count;
+} RecordBatch;
+
+// One symmetry class: its canonical board and how many input records fell into it
+typedef struct ClassEntry {
+    struct ClassEntry *next;
+    unsigned long long hash;
+    long long count;
+    int n;
+    unsigned char cells[];
+} ClassEntry;
+
+// Class table split into independently locked shards to keep workers from contending
+typedef struct {
+    ClassEntry **buckets;
+    int num_buckets;
+    int size;
+    pthread_mutex_t mutex;
+} ClassShard;
+
+ClassShard class_shards[CLASS_SHARDS];
+RecordBatch *record_batches = NULL;
+int num_record_batches = 0;
+int *free_batches = NULL;  // Batches the reader may fill
+int num_free_batches = 0;
+int *full_batches = NULL;  // Batches waiting for a worker
+int num_full_batches = 0;
+int batches_closed = 0;  // 1 once the reader has reached the end of the input
+pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t batch_filled = PTHREAD_COND_INITIALIZER;
+pthread_cond_t batch_emptied = PTHREAD_COND_INITIALIZER;
+long records_valid = 0;
+long records_invalid = 0;
+long reported_invalid = 0;
+const char *canonicalize_path = NULL;  // Input for canonicalizer mode (NULL = off, "-" = stdin)
+int binary_records = 0;  // 1 = canonicalizer input is raw N-byte records
+
 // Hash set to store canonical solutions with their unique ID
 typedef struct {
     char **solutions;
@@ -51,6 +182,19 @@ typedef struct {
 
 SolutionSet solution_set;
 
+// Pre-placed queen or forbidden cell supplied by the user
+typedef struct {
+    int row;
+    int col;
+    int is_queen;  // 1 = queen must be here, 0 = no queen may be here
+} Constraint;
+
+Constraint *constraints = NULL;
+int num_constraints = 0;
+int constraints_capacity = 0;
+int num_fixed_queens = 0;
+char *allowed = NULL;  // n*n mask of cells a queen may occupy (NULL = unconstrained)
+
 /**
  * Convert a board configuration to a string for comparison
  */
@@ -78,6 +222,27 @@ char *min_string(char *s1, char *s2) {
     }
 }
 
+/**
+ * Apply symmetry transform t to a board of the given size
+ * 0 = identity, 1-3 = rotations by 90/180/270° clockwise, 4-7 = horizontal,
+ * vertical, main-diagonal and anti-diagonal flips
+ */
+void apply_symmetry(int t, const int *b, int *out, int size) {
+    for (int row = 0; row < size; row++) {
+        int col = b[row];
+        switch (t) {
+            case 0: out[row] = col; break;  // Identity
+            case 1: out[col] = size - 1 - row; break;  // (row, col) -> (col, n-1-row)
+            case 2: out[size - 1 - row] = size - 1 - col; break;  // (row, col) -> (n-1-row, n-1-col)
+            case 3: out[size - 1 - col] = row; break;  // (row, col) -> (n-1-col, row)
+            case 4: out[row] = size - 1 - col; break;  // (row, col) -> (row, n-1-col)
+            case 5: out[size - 1 - row] = col; break;  // (row, col) -> (n-1-row, col)
+            case 6: out[col] = row; break;  // (row, col) -> (col, row)
+            case 7: out[size - 1 - col] = size - 1 - row; break;  // (row, col) -> (n-1-col, n-1-row)
+        }
+    }
+}
+
 /**
  * Apply transformations to generate all 8 symmetries
  * and return the lexicographically smallest one (canonical form)
@@ -86,54 +251,10 @@ char *get_canonical_form(int *b) {
     int *temp = (int *)malloc(n * sizeof(int));
     char *canonical = board_to_string(b);
     
-    // Rotation 90° clockwise: (row, col) -> (col, n-1-row)
-    for (int row = 0; row < n; row++) {
-        temp[b[row]] = n - 1 - row;  // If queen at (row, b[row]), new position: (b[row], n-1-row)
-    }
-    char *rotated90 = board_to_string(temp);
-    canonical = min_string(canonical, rotated90);
-    
-    // Rotation 180°: (row, col) -> (n-1-row, n-1-col)
-    for (int row = 0; row < n; row++) {
-        temp[n - 1 - b[row]] = n - 1 - row;
-    }
-    char *rotated180 = board_to_string(temp);
-    canonical = min_string(canonical, rotated180);
-    
-    // Rotation 270° clockwise: (row, col) -> (n-1-col, row)
-    for (int row = 0; row < n; row++) {
-        temp[n - 1 - b[row]] = row;
-    }
-    char *rotated270 = board_to_string(temp);
-    canonical = min_string(canonical, rotated270);
-    
-    // Horizontal flip: (row, col) -> (row, n-1-col)
-    for (int row = 0; row < n; row++) {
-        temp[row] = n - 1 - b[row];
-    }
-    char *flipped_h = board_to_string(temp);
-    canonical = min_string(canonical, flipped_h);
-    
-    // Vertical flip: (row, col) -> (n-1-row, col)
-    for (int row = 0; row < n; row++) {
-        temp[n - 1 - row] = b[row];
-    }
-    char *flipped_v = board_to_string(temp);
-    canonical = min_string(canonical, flipped_v);
-    
-    // Diagonal flip (main): (row, col) -> (col, row)
-    for (int row = 0; row < n; row++) {
-        temp[b[row]] = row;
-    }
-    char *flipped_diag = board_to_string(temp);
-    canonical = min_string(canonical, flipped_diag);
-    
-    // Anti-diagonal flip: (row, col) -> (n-1-col, n-1-row)
-    for (int row = 0; row < n; row++) {
-        temp[n - 1 - b[row]] = n - 1 - row;
+    for (int t = 1; t < 8; t++) {
+        apply_symmetry(t, b, temp, n);
+        canonical = min_string(canonical, board_to_string(temp));
     }
-    char *flipped_antidiag = board_to_string(temp);
-    canonical = min_string(canonical, flipped_antidiag);
     
     free(temp);
     return canonical;
@@ -168,6 +289,121 @@ void add_to_set(char *canonical, int unique_id) {
     solution_set.size++;
 }
 
+/**
+ * Record a pre-placed queen or forbidden cell (validated once N is known)
+ */
+void add_constraint(int row, int col, int is_queen) {
+    if (num_constraints >= constraints_capacity) {
+        constraints_capacity = (constraints_capacity > 0) ? constraints_capacity * 2 : 16;
+        constraints = (Constraint *)realloc(constraints, constraints_capacity * sizeof(Constraint));
+    }
+    constraints[num_constraints].row = row;
+    constraints[num_constraints].col = col;
+    constraints[num_constraints].is_queen = is_queen;
+    num_constraints++;
+}
+
+/**
+ * Parse a "ROW,COL" cell argument
+ * Returns 1 on success, 0 on malformed input
+ */
+int parse_cell(const char *text, int *row, int *col) {
+    char extra;
+    return sscanf(text, "%d,%d%c", row, col, &extra) == 2;
+}
+
+/**
+ * Load constraints from a file, one per line:
+ *   Q ROW COL   pre-placed queen
+ *   X ROW COL   forbidden cell
+ * Blank lines and lines starting with '#' are ignored
+ * Returns 0 on success, -1 on error
+ */
+int load_constraints_file(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot open constraints file '%s'\n", path);
+        return -1;
+    }
+    
+    char line[256];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char kind;
+        int row, col;
+        char *p = line;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') {
+            continue;
+        }
+        if (sscanf(p, " %c %d %d", &kind, &row, &col) != 3 ||
+            (kind != 'Q' && kind != 'q' && kind != 'X' && kind != 'x')) {
+            fprintf(stderr, "Error: %s:%d: expected 'Q ROW COL' or 'X ROW COL'\n", path, line_number);
+            fclose(file);
+            return -1;
+        }
+        add_constraint(row, col, kind == 'Q' || kind == 'q');
+    }
+    
+    fclose(file);
+    return 0;
+}
+
+/**
+ * Build the allowed-cell mask from the recorded constraints
+ * Every cell attacked by a pre-placed queen is ruled out, so the search
+ * only ever considers placements compatible with the fixed queens
+ * Returns 0 on success, -1 if the constraints are out of range or contradictory
+ */
+int build_allowed_mask(void) {
+    if (num_constraints == 0) {
+        return 0;
+    }
+    
+    allowed = (char *)malloc((size_t)n * n);
+    if (!allowed) {
+        fprintf(stderr, "Error: Not enough memory for the %dx%d constraint mask\n", n, n);
+        return -1;
+    }
+    memset(allowed, 1, (size_t)n * n);
+    
+    for (int i = 0; i < num_constraints; i++) {
+        Constraint *c = &constraints[i];
+        if (c->row < 0 || c->row >= n || c->col < 0 || c->col >= n) {
+            fprintf(stderr, "Error: Cell (%d,%d) is outside the %dx%d board\n", c->row, c->col, n, n);
+            return -1;
+        }
+        if (!c->is_queen) {
+            allowed[(size_t)c->row * n + c->col] = 0;
+        }
+    }
+    
+    for (int i = 0; i < num_constraints; i++) {
+        Constraint *q = &constraints[i];
+        if (!q->is_queen) {
+            continue;
+        }
+        if (!allowed[(size_t)q->row * n + q->col]) {
+            fprintf(stderr, "Error: Queen at (%d,%d) is on a forbidden or attacked cell\n", q->row, q->col);
+            return -1;
+        }
+        for (int row = 0; row < n; row++) {
+            for (int col = 0; col < n; col++) {
+                if ((row == q->row) != (col == q->col) ||
+                    (row != q->row && abs(row - q->row) == abs(col - q->col))) {
+                    allowed[(size_t)row * n + col] = 0;
+                }
+            }
+        }
+        num_fixed_queens++;
+    }
+    
+    return 0;
+}
+
 /**
  * Print a solution
  */
@@ -186,26 +422,149 @@ void print_solution(int *b, int num) {
 }
 
 /**
- * Add a work item to the queue
+ * Get the current wall-clock time in seconds
  */
-void add_work_item(int *partial_board) {
-    if (work_queue.size >= work_queue.capacity) {
-        work_queue.capacity *= 2;
-        work_queue.items = (WorkItem *)realloc(work_queue.items,
-                                               work_queue.capacity * sizeof(WorkItem));
+double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Check whether the search has been cancelled
+ */
+int search_stopped(void) {
+    return __atomic_load_n(&stop_search, __ATOMIC_RELAXED);
+}
+
+/**
+ * Cancel the search and wake the producer and any waiting workers so they can exit
+ */
+void request_stop(void) {
+    __atomic_store_n(&stop_search, 1, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&queue_mutex);
+    pthread_cond_broadcast(&queue_not_empty);
+    pthread_cond_broadcast(&queue_not_full);
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+/**
+ * Allocate the slots of one ring buffer
+ */
+void init_queue_slots(WorkQueue *queue, int capacity) {
+    queue->capacity = capacity;
+    queue->items = (WorkItem *)malloc(capacity * sizeof(WorkItem));
+    queue->storage = (int *)malloc((size_t)capacity * n * sizeof(int));
+    for (int i = 0; i < capacity; i++) {
+        queue->items[i].board = &queue->storage[i * n];
+        queue->items[i].depth = 0;
+        queue->items[i].job = NULL;
+    }
+    queue->head = 0;
+    queue->tail = 0;
+    queue->count = 0;
+    queue->closed = 0;
+}
+
+/**
+ * Allocate the bounded work queue with the given number of slots
+ */
+void init_work_queue(int capacity) {
+    init_queue_slots(&work_queue, capacity);
+}
+
+/**
+ * Release the work queue and the priority lane (if the server allocated one)
+ */
+void free_work_queue(void) {
+    free(work_queue.storage);
+    free(work_queue.items);
+    free(priority_queue.storage);
+    free(priority_queue.items);
+}
+
+/**
+ * Push a partial board for the given job onto the queue
+ * Blocks while the queue is full so producers never run far ahead of the workers
+ * Returns 1 if queued, 0 if refused because the search was cancelled or the queue closed
+ */
+int push_work_item(const int *partial_board, int depth, BatchJob *job) {
+    WorkQueue *queue = (job && job->priority) ? &priority_queue : &work_queue;
+    pthread_mutex_lock(&queue_mutex);
+    while (queue->count >= queue->capacity && !search_stopped() && !work_queue.closed) {
+        pthread_cond_wait(&queue_not_full, &queue_mutex);
+    }
+    if (search_stopped() || work_queue.closed) {
+        pthread_mutex_unlock(&queue_mutex);
+        return 0;  // Nobody will consume it
     }
     
-    WorkItem *item = &work_queue.items[work_queue.size];
-    item->board = (int *)malloc(n * sizeof(int));
+    WorkItem *item = &queue->items[queue->tail];
     memcpy(item->board, partial_board, n * sizeof(int));
-    item->depth = parallelization_depth;
-    work_queue.size++;
+    item->depth = depth;
+    item->job = job;
+    queue->tail = (queue->tail + 1) % queue->capacity;
+    queue->count++;
+    total_work_items++;
+    
+    pthread_cond_signal(&queue_not_empty);
+    pthread_mutex_unlock(&queue_mutex);
+    return 1;
+}
+
+/**
+ * Add a work item for the single-size solve to the queue
+ */
+void add_work_item(int *partial_board) {
+    push_work_item(partial_board, parallelization_depth, NULL);
+}
+
+/**
+ * Mark the queue as complete and wake any workers waiting for more items
+ */
+void close_work_queue(void) {
+    pthread_mutex_lock(&queue_mutex);
+    work_queue.closed = 1;
+    pthread_cond_broadcast(&queue_not_empty);
+    pthread_cond_broadcast(&queue_not_full);
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+/**
+ * Take the next work item, copying its partial board into dest and its batch job into job
+ * Blocks until an item is available; returns the starting depth, or -1 when the queue is drained
+ */
+int take_work_item(int *dest, BatchJob **job) {
+    pthread_mutex_lock(&queue_mutex);
+    while (work_queue.count == 0 && priority_queue.count == 0 && !work_queue.closed && !search_stopped()) {
+        pthread_cond_wait(&queue_not_empty, &queue_mutex);
+    }
+    if ((work_queue.count == 0 && priority_queue.count == 0) || search_stopped()) {
+        pthread_mutex_unlock(&queue_mutex);
+        return -1;  // Producer finished and nothing left, or the search was cancelled
+    }
+    
+    WorkQueue *queue = (priority_queue.count > 0) ? &priority_queue : &work_queue;
+    WorkItem *item = &queue->items[queue->head];
+    memcpy(dest, item->board, n * sizeof(int));
+    int depth = item->depth;
+    *job = item->job;
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+    
+    // Producers of both lanes share the condition, so wake them all
+    pthread_cond_broadcast(&queue_not_full);
+    pthread_mutex_unlock(&queue_mutex);
+    return depth;
 }
 
 /**
  * Check if it's safe to place a queen (using provided board)
  */
 int is_safe_with_board(int row, int col, int *b) {
+    if (allowed && !allowed[(size_t)row * n + col]) {
+        return 0;
+    }
     for (int i = 0; i < row; i++) {
         if (b[i] == col) {
             return 0;
@@ -221,6 +580,9 @@ int is_safe_with_board(int row, int col, int *b) {
  * Generate all partial board configurations up to parallelization_depth
  */
 void generate_work_queue(int row, int *partial_board) {
+    if (search_stopped()) {
+        return;
+    }
     if (row == parallelization_depth) {
         // Found a valid partial board - add to work queue
         add_work_item(partial_board);
@@ -239,6 +601,9 @@ void generate_work_queue(int row, int *partial_board) {
  * Check if it's safe to place a queen (using thread-local board)
  */
 int is_safe(int row, int col) {
+    if (allowed && !allowed[(size_t)row * n + col]) {
+        return 0;
+    }
     for (int i = 0; i < row; i++) {
         if (board[i] == col) {
             return 0;
@@ -258,7 +623,16 @@ void solve_nqueens(int row) {
         // Protect all shared data access with mutex
         pthread_mutex_lock(&data_mutex);
         
+        // Another thread may have hit the limit while this one was searching
+        if (search_stopped()) {
+            pthread_mutex_unlock(&data_mutex);
+            return;
+        }
+        
         solutions_count++;
+        if (solutions_count == 1) {
+            first_solution_wall = wall_time();
+        }
         
         // Get canonical form
         char *canonical = get_canonical_form(board);
@@ -274,6 +648,11 @@ void solve_nqueens(int row) {
             free(canonical);
         }
         
+        if ((solution_limit > 0 && solutions_count >= solution_limit) ||
+            (unique_limit > 0 && unique_count >= unique_limit)) {
+            request_stop();
+        }
+        
         pthread_mutex_unlock(&data_mutex);
         
         // Now print with print_mutex (separate to not hold data_mutex while printing)
@@ -298,6 +677,9 @@ void solve_nqueens(int row) {
     }
     
     for (int col = 0; col < n; col++) {
+        if (search_stopped()) {
+            return;
+        }
         if (is_safe(row, col)) {
             board[row] = col;
             solve_nqueens(row + 1);
@@ -305,19 +687,21 @@ void solve_nqueens(int row) {
     }
 }
 
-// Mutex for work queue access
-pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
-int queue_index = 0;
-
 /**
  * Update and display progress
  */
 void update_progress(void) {
     if (!show_progress) return;
     
+    // Snapshot how many items exist so far; the total only settles once the producer is done
+    pthread_mutex_lock(&queue_mutex);
+    int total = total_work_items;
+    int producing = !work_queue.closed;
+    pthread_mutex_unlock(&queue_mutex);
+    
     pthread_mutex_lock(&progress_mutex);
     work_completed++;
-    double percent = (double)work_completed / total_work_items * 100.0;
+    double percent = (double)work_completed / total * 100.0;
     
     // Create a simple progress bar
     int bar_length = 30;
@@ -328,7 +712,7 @@ void update_progress(void) {
     for (int i = 0; i < bar_length; i++) {
         fprintf(stderr, "%c", i < filled ? '=' : ' ');
     }
-    fprintf(stderr, "] %.1f%% (%d/%d)", percent, work_completed, total_work_items);
+    fprintf(stderr, "] %.1f%% (%d/%d%s)", percent, work_completed, total, producing ? "+" : "");
     fflush(stderr);
     
     pthread_mutex_unlock(&progress_mutex);
@@ -336,147 +720,1488 @@ void update_progress(void) {
 
 /**
  * Thread worker function
- * Each thread picks work items from the queue and solves them
+ * Each thread picks work items from the queue as the producer emits them and solves them
  */
 void *thread_worker(void *arg) {
     // Each thread gets its own board (thread-local storage)
     board = (int *)malloc(n * sizeof(int));
+    scratch = (int *)malloc(n * sizeof(int));
     
     while (1) {
-        // Get next work item from queue
-        pthread_mutex_lock(&queue_mutex);
-        if (queue_index >= work_queue.size) {
-            pthread_mutex_unlock(&queue_mutex);
+        // Copy the next partial board to thread-local board (blocks until one is available)
+        BatchJob *job;
+        int depth = take_work_item(board, &job);
+        if (depth < 0) {
             break;  // No more work
         }
         
-        WorkItem *item = &work_queue.items[queue_index];
-        queue_index++;
-        
-        pthread_mutex_unlock(&queue_mutex);
-        
-        // Copy the partial board to thread-local board
-        memcpy(board, item->board, n * sizeof(int));
-        
         // Solve from the parallelization depth
-        solve_nqueens(item->depth);
+        if (job) {
+            solve_batch_item(job, depth);
+        } else {
+            solve_nqueens(depth);
+        }
         
         // Update progress
         update_progress();
     }
     
     free(board);
+    free(scratch);
     return NULL;
 }
 
 /**
- * Print usage information
+ * Compare two boards of the given size lexicographically (like memcmp)
  */
-void print_usage(const char *program_name) {
-    printf("Usage: %s [OPTIONS]\n\n", program_name);
-    printf("Solve the N-Queens problem using multi-threaded backtracking with symmetry detection.\n\n");
-    printf("OPTIONS:\n");
-    printf("  n [N]              Board size (default: 8)\n");
-    printf("  --threads NUM      Number of threads to use (default: auto-detect)\n");
-    printf("  --quiet            Don't print intermediate solutions, only final summary\n");
-    printf("  --progress         Show progress bar during solving\n");
-    printf("  --help             Show this help message\n\n");
-    printf("EXAMPLES:\n");
-    printf("  %s                    # Solve 8-queens with auto-detected threads\n", program_name);
-    printf("  %s 10                 # Solve 10-queens\n", program_name);
-    printf("  %s 8 --threads 4      # Solve 8-queens using exactly 4 threads\n", program_name);
-    printf("  %s 12 --progress      # Solve 12-queens and show progress\n", program_name);
-    printf("  %s 12 --threads 8 --quiet --progress  # All options\n", program_name);
+int compare_boards(const int *a, const int *b, int size) {
+    for (int row = 0; row < size; row++) {
+        if (a[row] != b[row]) {
+            return (a[row] < b[row]) ? -1 : 1;
+        }
+    }
+    return 0;
 }
 
-int main(int argc, char *argv[]) {
-    n = 8;
-    num_threads = 0;  // 0 means auto-detect
-    print_solutions = 1;  // 1 means print solutions
-    
-    // Parse command line arguments
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
-            print_usage(argv[0]);
-            return 0;
-        } else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0) {
-            print_solutions = 0;
-        } else if (strcmp(argv[i], "--progress") == 0 || strcmp(argv[i], "-p") == 0) {
-            show_progress = 1;
-        } else if (strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) {
-            if (i + 1 < argc) {
-                num_threads = atoi(argv[++i]);
-                if (num_threads < 1) {
-                    fprintf(stderr, "Error: Thread count must be at least 1\n");
-                    return 1;
+/**
+ * Check whether a complete board is the lexicographically smallest member of its
+ * symmetry class; exactly one board per class passes, so uniques can be counted
+ * without a shared solution set
+ */
+int is_canonical_board(const int *b, int *temp, int size) {
+    for (int t = 1; t < 8; t++) {
+        apply_symmetry(t, b, temp, size);
+        for (int row = 0; row < size; row++) {
+            if (temp[row] != b[row]) {
+                if (temp[row] < b[row]) {
+                    return 0;
                 }
-            } else {
-                fprintf(stderr, "Error: --threads requires a number argument\n");
-                return 1;
-            }
-        } else if (argv[i][0] != '-') {
-            // Positional argument - board size
-            n = atoi(argv[i]);
-            if (n < 1) {
-                fprintf(stderr, "Error: N must be at least 1\n");
-                return 1;
+                break;
             }
-        } else {
-            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
-            print_usage(argv[0]);
-            return 1;
         }
     }
-    
-    // Detect number of CPU cores
-    num_cores = sysconf(_SC_NPROCESSORS_ONLN);
-    if (num_cores < 1) {
-        num_cores = 1;
+    return 1;
+}
+
+/**
+ * Check if it's safe to place a queen on a board of the given size
+ */
+int is_safe_sized(int row, int col, const int *b) {
+    for (int i = 0; i < row; i++) {
+        if (b[i] == col || abs(b[i] - col) == abs(i - row)) {
+            return 0;
+        }
     }
+    return 1;
+}
+
+// Signalled whenever any batch/server job finishes its last item, or has output to send
+pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+
+/**
+ * Queue one solution of a server job for its client as "SOL <U|V> c0 c1 ..."
+ * (U = canonical representative, V = symmetric variant)
+ * Workers never touch the socket: the client thread sends the buffer, and a
+ * client that stops reading has its job cancelled once SERVER_OUT_LIMIT is buffered
+ */
+void emit_solution(BatchJob *job, const int *b, int canonical) {
+    char line[16 + 12 * 64];
+    int len = snprintf(line, sizeof(line), "SOL %c", canonical ? 'U' : 'V');
+    for (int row = 0; row < job->n; row++) {
+        len += snprintf(line + len, sizeof(line) - len, " %d", b[row]);
+    }
+    line[len++] = '\n';
     
-    // Use user-specified thread count or auto-detected cores
-    int actual_threads = (num_threads > 0) ? num_threads : num_cores;
-    
-    solution_set.capacity = 1000;
-    solution_set.solutions = (char **)malloc(solution_set.capacity * sizeof(char *));
-    solution_set.unique_ids = (int *)malloc(solution_set.capacity * sizeof(int));
-    solution_set.size = 0;
-    
-    printf("╔════════════════════════════════════════════════════════════╗\n");
-    printf("║  UNIQUE SOLUTIONS (ACCOUNTING FOR SYMMETRY)  QUEENS-%3d    ║\n", n);
-    printf("║  Solutions that are the same after rotation or reflection  ║\n");
-    printf("║  are counted as one unique solution                        ║\n");
-    printf("║  Detected %d CPU core(s)                                   ║\n", num_cores);
-    printf("║  Using %d thread(s) | %s intermediate solutions           ║\n", 
-           actual_threads, print_solutions ? "Printing" : "Suppressing");
-    printf("╚════════════════════════════════════════════════════════════╝\n\n");
-    
-    clock_t start = clock();
-    
-    // Calculate parallelization depth
-    // Higher depth = more granular work items = better load balancing on many cores
-    // For most cases, depth 3-4 provides good balance between generation cost and work granularity
-    parallelization_depth = (n > 6) ? 4 : (n > 4) ? 3 : 2;
-    if (parallelization_depth > n - 1) {
-        parallelization_depth = n - 1;
+    int wake = 0;
+    pthread_mutex_lock(&job->out_mutex);
+    if (!__atomic_load_n(&job->stopped, __ATOMIC_RELAXED)) {
+        if (job->out_length + len > SERVER_OUT_LIMIT) {
+            __atomic_store_n(&job->cancelled, 1, __ATOMIC_RELAXED);  // Client stopped reading
+            __atomic_store_n(&job->stopped, 1, __ATOMIC_RELAXED);
+        } else {
+            if (job->out_length + len > job->out_capacity) {
+                job->out_capacity = job->out_capacity ? job->out_capacity * 2 : 4096;
+                job->out_buffer = (char *)realloc(job->out_buffer, job->out_capacity);
+            }
+            memcpy(job->out_buffer + job->out_length, line, len);
+            wake = (job->out_length < SERVER_OUT_FLUSH && job->out_length + len >= SERVER_OUT_FLUSH);
+            job->out_length += len;
+            job->solutions++;
+            job->uniques += canonical;
+            if (job->limit > 0 && job->solutions >= job->limit) {
+                __atomic_store_n(&job->stopped, 1, __ATOMIC_RELAXED);
+            }
+        }
     }
+    pthread_mutex_unlock(&job->out_mutex);
     
-    // Initialize work queue
-    work_queue.capacity = 10000;
-    work_queue.items = (WorkItem *)malloc(work_queue.capacity * sizeof(WorkItem));
-    work_queue.size = 0;
+    if (wake) {
+        pthread_mutex_lock(&job_mutex);
+        pthread_cond_broadcast(&job_done);
+        pthread_mutex_unlock(&job_mutex);
+    }
+}
+
+/**
+ * Count solutions and canonical solutions below a batch work item
+ */
+void count_batch(BatchJob *job, int row, long long *solutions, long long *uniques) {
+    int size = job->n;
+    if (row == size) {
+        int canonical = is_canonical_board(board, scratch, size);
+        if (job->out_fd >= 0) {
+            emit_solution(job, board, canonical);
+            return;
+        }
+        (*solutions)++;
+        if (canonical) {
+            (*uniques)++;
+        }
+        return;
+    }
+    
+    for (int col = 0; col < size; col++) {
+        if (__atomic_load_n(&job->stopped, __ATOMIC_RELAXED)) {
+            return;
+        }
+        if (is_safe_sized(row, col, board)) {
+            board[row] = col;
+            count_batch(job, row + 1, solutions, uniques);
+        }
+    }
+}
+
+/**
+ * Drop one outstanding item from a batch job, stamping its finish time when it was the last
+ * The decrement happens under job_mutex so a waiter cannot see the job finished (and
+ * release it) while this thread is still writing to it
+ */
+void finish_batch_item(BatchJob *job) {
+    pthread_mutex_lock(&job_mutex);
+    if (__atomic_sub_fetch(&job->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        job->end_wall = wall_time();
+        pthread_cond_broadcast(&job_done);
+    }
+    pthread_mutex_unlock(&job_mutex);
+}
+
+/**
+ * Cancel a server job if its client has hung up or the server is shutting down
+ * A client that only closed its write side (EOF on our read side) can still
+ * receive the reply, so just POLLHUP/POLLERR count as a hangup
+ */
+void check_job_client(BatchJob *job) {
+    int gone = 0;
+    if (!__atomic_load_n(&server_running, __ATOMIC_RELAXED)) {
+        gone = 1;
+    } else {
+        struct pollfd pfd;
+        pfd.fd = job->client_fd;
+        pfd.events = 0;  // POLLHUP and POLLERR are always reported
+        pfd.revents = 0;
+        gone = poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL));
+    }
+    if (gone) {
+        __atomic_store_n(&job->cancelled, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&job->stopped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Send the SOL lines queued so far to a streaming job's client
+ * Runs on the client thread, so only this client waits if the socket is full
+ */
+void flush_job_output(BatchJob *job) {
+    pthread_mutex_lock(&job->out_mutex);
+    char *data = job->out_buffer;
+    size_t capacity = job->out_capacity;
+    size_t length = job->out_length;
+    job->out_buffer = job->send_buffer;
+    job->out_capacity = job->send_capacity;
+    job->out_length = 0;
+    job->send_buffer = data;
+    job->send_capacity = capacity;
+    pthread_mutex_unlock(&job->out_mutex);
+    
+    size_t sent = 0;
+    while (sent < length && !__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED)) {
+        ssize_t written = send(job->out_fd, data + sent, length - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            __atomic_store_n(&job->cancelled, 1, __ATOMIC_RELAXED);  // Client went away
+            __atomic_store_n(&job->stopped, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        sent += written;
+    }
+}
+
+/**
+ * Block until every item of a job has been solved
+ * Jobs with a client are re-checked every 50ms so a hangup cancels the remaining work,
+ * and streaming jobs send their buffered solutions in the meantime
+ */
+void wait_for_job(BatchJob *job) {
+    pthread_mutex_lock(&job_mutex);
+    while (__atomic_load_n(&job->pending, __ATOMIC_ACQUIRE) != 0) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += 50 * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&job_done, &job_mutex, &deadline);
+        if (job->client_fd >= 0) {
+            pthread_mutex_unlock(&job_mutex);
+            check_job_client(job);
+            if (job->out_fd >= 0) {
+                flush_job_output(job);
+            }
+            pthread_mutex_lock(&job_mutex);
+        }
+    }
+    pthread_mutex_unlock(&job_mutex);
+    if (job->out_fd >= 0) {
+        flush_job_output(job);
+    }
+}
+
+/**
+ * Solve one batch work item and fold its counts into the owning job
+ */
+void solve_batch_item(BatchJob *job, int depth) {
+    long long solutions = 0;
+    long long uniques = 0;
+    count_batch(job, depth, &solutions, &uniques);
+    
+    // Streaming jobs count under out_mutex in emit_solution instead
+    if (job->out_fd < 0) {
+        __atomic_add_fetch(&job->solutions, solutions, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&job->uniques, uniques, __ATOMIC_RELAXED);
+    }
+    finish_batch_item(job);
+}
+
+/**
+ * Emit every partial board of a batch job up to its parallelization depth
+ */
+void generate_batch_items(BatchJob *job, int row, int *partial_board) {
+    if (__atomic_load_n(&job->stopped, __ATOMIC_RELAXED)) {
+        return;
+    }
+    if (row == job->depth) {
+        // Count the item before queueing it; the producer's hold keeps pending above zero
+        __atomic_add_fetch(&job->pending, 1, __ATOMIC_ACQ_REL);
+        if (!push_work_item(partial_board, job->depth, job)) {
+            finish_batch_item(job);
+            return;
+        }
+        job->work_items++;
+        if (job->client_fd >= 0) {
+            check_job_client(job);
+        }
+        if (job->out_fd >= 0) {
+            flush_job_output(job);  // The producer is the client thread, so keep streaming
+        }
+        return;
+    }
+    
+    for (int col = 0; col < job->n; col++) {
+        if (is_safe_sized(row, col, partial_board)) {
+            partial_board[row] = col;
+            generate_batch_items(job, row + 1, partial_board);
+        }
+    }
+}
+
+/**
+ * Parse a batch specification such as "4-16" or "4,6,8-10" into batch_jobs
+ * Returns 0 on success, -1 on malformed input or sizes above MAX_BATCH_N
+ */
+int parse_batch_spec(const char *spec) {
+    const char *p = spec;
+    while (*p) {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        long hi = lo;
+        if (end == p) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            p++;
+            hi = strtol(p, &end, 10);
+            if (end == p) {
+                return -1;
+            }
+            p = end;
+        }
+        if (lo < 1 || hi < lo || hi > MAX_BATCH_N) {
+            return -1;
+        }
+        for (long size = lo; size <= hi; size++) {
+            if (num_batch_jobs >= batch_jobs_capacity) {
+                batch_jobs_capacity = batch_jobs_capacity ? batch_jobs_capacity * 2 : 16;
+                batch_jobs = (BatchJob *)realloc(batch_jobs, batch_jobs_capacity * sizeof(BatchJob));
+            }
+            memset(&batch_jobs[num_batch_jobs], 0, sizeof(BatchJob));
+            batch_jobs[num_batch_jobs].n = (int)size;
+            batch_jobs[num_batch_jobs].out_fd = -1;
+            batch_jobs[num_batch_jobs].client_fd = -1;
+            num_batch_jobs++;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+    return num_batch_jobs > 0 ? 0 : -1;
+}
+
+/**
+ * Pick the parallelization depth for a board size
+ * Higher depth = more granular work items = better load balancing on many cores
+ * For most cases, depth 3-4 provides good balance between generation cost and work granularity
+ */
+int depth_for_size(int size) {
+    int depth = (size > 6) ? 4 : (size > 4) ? 3 : 2;
+    if (depth > size - 1) {
+        depth = size - 1;
+    }
+    return depth;
+}
+
+/**
+ * Producer for the small batch sizes (in the order given), feeding the priority lane
+ */
+void *produce_small_batch_jobs(void *arg) {
+    (void)arg;
+    int *partial_board = (int *)malloc(n * sizeof(int));
+    for (int i = 0; i < num_batch_jobs; i++) {
+        BatchJob *job = &batch_jobs[i];
+        if (!job->priority) {
+            continue;
+        }
+        memset(partial_board, -1, n * sizeof(int));
+        generate_batch_items(job, 0, partial_board);
+        finish_batch_item(job);  // Release the producer's hold
+    }
+    free(partial_board);
+    return NULL;
+}
+
+/**
+ * Batch mode: solve every requested board size on one persistent thread pool
+ * Large sizes are produced largest first so their long-running items start early.
+ * Sizes at least BATCH_PRIORITY_GAP below the largest go through the priority lane
+ * from a second producer, so they finish early instead of queueing behind the large ones
+ */
+int run_batch(int actual_threads) {
+    // The queue slots and worker boards are sized for the largest board
+    n = 0;
+    for (int i = 0; i < num_batch_jobs; i++) {
+        if (batch_jobs[i].n > n) {
+            n = batch_jobs[i].n;
+        }
+        batch_jobs[i].depth = depth_for_size(batch_jobs[i].n);
+        batch_jobs[i].pending = 1;  // Held by the producer until all items are emitted
+    }
+    for (int i = 0; i < num_batch_jobs; i++) {
+        batch_jobs[i].priority = (batch_jobs[i].n + BATCH_PRIORITY_GAP <= n);
+    }
+    
+    init_work_queue((queue_size > 0) ? queue_size : 64 * actual_threads);
+    init_queue_slots(&priority_queue, work_queue.capacity);
+    start_wall = wall_time();
+    
+    pthread_t *threads = (pthread_t *)malloc(actual_threads * sizeof(pthread_t));
+    for (int i = 0; i < actual_threads; i++) {
+        pthread_create(&threads[i], NULL, thread_worker, NULL);
+    }
+    
+    // Small sizes are produced on their own thread into the priority lane, so they
+    // are solved while the large sizes are still being produced rather than after them
+    pthread_t small_producer;
+    pthread_create(&small_producer, NULL, produce_small_batch_jobs, NULL);
+    
+    // Visit the large sizes from largest to smallest
+    int *order = (int *)malloc(num_batch_jobs * sizeof(int));
+    for (int i = 0; i < num_batch_jobs; i++) {
+        order[i] = i;
+    }
+    for (int i = 1; i < num_batch_jobs; i++) {
+        for (int j = i; j > 0 && batch_jobs[order[j]].n > batch_jobs[order[j - 1]].n; j--) {
+            int swap = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+    }
+    
+    int *partial_board = (int *)malloc(n * sizeof(int));
+    for (int i = 0; i < num_batch_jobs; i++) {
+        BatchJob *job = &batch_jobs[order[i]];
+        if (job->priority) {
+            continue;
+        }
+        memset(partial_board, -1, n * sizeof(int));
+        generate_batch_items(job, 0, partial_board);
+        finish_batch_item(job);  // Release the producer's hold
+    }
+    free(partial_board);
+    free(order);
+    pthread_join(small_producer, NULL);
+    close_work_queue();
+    
+    for (int i = 0; i < actual_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    if (show_progress) {
+        fprintf(stderr, "\r%-60s\r", "");
+    }
+    
+    double elapsed_wall = wall_time() - start_wall;
+    
+    printf("╔════════╦══════════════════╦══════════════════╦════════════╦══════════════╗\n");
+    printf("║      N ║        Solutions ║           Unique ║ Work items ║  Done at (s) ║\n");
+    printf("╠════════╬══════════════════╬══════════════════╬════════════╬══════════════╣\n");
+    for (int i = 0; i < num_batch_jobs; i++) {
+        BatchJob *job = &batch_jobs[i];
+        printf("║ %6d ║ %16lld ║ %16lld ║ %10d ║ %12.6f ║\n", job->n, job->solutions,
+               job->uniques, job->work_items, job->end_wall - start_wall);
+    }
+    printf("╚════════╩══════════════════╩══════════════════╩════════════╩══════════════╝\n");
+    printf("\nWall time: %.6f seconds | Board sizes: %d | Work items: %d\n",
+           elapsed_wall, num_batch_jobs, total_work_items);
+    
+    free(threads);
+    free_work_queue();
+    free(batch_jobs);
+    return 0;
+}
+
+/**
+ * Set a bit in a bitmask, returning whether it was already set
+ */
+int test_and_set_bit(uint64_t *bits, int index) {
+    uint64_t mask = (uint64_t)1 << (index & 63);
+    int was_set = (bits[index >> 6] & mask) != 0;
+    bits[index >> 6] |= mask;
+    return was_set;
+}
+
+/**
+ * Verify a complete placement in O(N) using column and diagonal occupancy bitmasks
+ * bits must hold 3 * VERIFY_WORDS(size) words; it is cleared here
+ * Returns NULL if valid, otherwise a short reason
+ */
+const char *verify_placement(const int *b, int size, uint64_t *bits) {
+    int words = VERIFY_WORDS(size);
+    uint64_t *cols = bits;
+    uint64_t *diags = bits + words;           // row + col, 2N-1 entries
+    uint64_t *anti_diags = bits + 2 * words;  // row - col + N - 1, 2N-1 entries
+    memset(bits, 0, 3 * words * sizeof(uint64_t));
+    
+    for (int row = 0; row < size; row++) {
+        int col = b[row];
+        if (col < 0 || col >= size) {
+            return "column out of range";
+        }
+        if (test_and_set_bit(cols, col)) {
+            return "two queens share a column";
+        }
+        if (test_and_set_bit(diags, row + col) || test_and_set_bit(anti_diags, row - col + size - 1)) {
+            return "two queens share a diagonal";
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Run one server request on the shared pool and wait for it to finish
+ * With out_fd >= 0 every solution is streamed to the client as it is found;
+ * the job is cancelled early if client_fd hangs up
+ */
+void run_server_job(BatchJob *job, int size, int client_fd, int out_fd, long long limit) {
+    memset(job, 0, sizeof(BatchJob));
+    job->n = size;
+    job->depth = depth_for_size(size);
+    // Keep items short so a worker is soon free for the next small request
+    if (job->depth < size - SERVER_ITEM_ROWS) {
+        job->depth = size - SERVER_ITEM_ROWS;
+    }
+    job->priority = (size <= SERVER_PRIORITY_N);
+    job->pending = 1;  // Held by this producer until all items are emitted
+    job->client_fd = client_fd;
+    job->out_fd = out_fd;
+    job->limit = limit;
+    pthread_mutex_init(&job->out_mutex, NULL);
+    
+    // push_work_item copies whole queue slots, which are sized for MAX_SERVER_N
+    int *partial_board = (int *)malloc(MAX_SERVER_N * sizeof(int));
+    memset(partial_board, -1, MAX_SERVER_N * sizeof(int));
+    generate_batch_items(job, 0, partial_board);
+    free(partial_board);
+    finish_batch_item(job);
+    
+    wait_for_job(job);
+    free(job->out_buffer);
+    free(job->send_buffer);
+    pthread_mutex_destroy(&job->out_mutex);
+}
+
+/**
+ * Handle one request line from a client
+ * Returns 0 when the client asked to close the connection, 1 otherwise
+ */
+int handle_request(int fd, char *line) {
+    char command[16];
+    int consumed = 0;
+    if (sscanf(line, "%15s%n", command, &consumed) != 1) {
+        return 1;  // Blank line
+    }
+    char *args = line + consumed;
+    __atomic_add_fetch(&requests_served, 1, __ATOMIC_RELAXED);
+    
+    if (strcmp(command, "COUNT") == 0) {
+        int size;
+        if (sscanf(args, "%d", &size) != 1 || size < 1 || size > MAX_SERVER_N) {
+            dprintf(fd, "ERR COUNT needs N between 1 and %d\n", MAX_SERVER_N);
+            return 1;
+        }
+        
+        pthread_mutex_lock(&cache_mutex);
+        CachedCount cached = count_cache[size];
+        pthread_mutex_unlock(&cache_mutex);
+        if (cached.valid) {
+            __atomic_add_fetch(&cache_hits, 1, __ATOMIC_RELAXED);
+            dprintf(fd, "OK %d %lld %lld cached\n", size, cached.solutions, cached.uniques);
+            return 1;
+        }
+        
+        BatchJob job;
+        double start = wall_time();
+        run_server_job(&job, size, fd, -1, 0);
+        double elapsed = wall_time() - start;
+        if (job.cancelled) {
+            return 0;  // Partial counts must not reach the cache
+        }
+        
+        pthread_mutex_lock(&cache_mutex);
+        count_cache[size].solutions = job.solutions;
+        count_cache[size].uniques = job.uniques;
+        count_cache[size].valid = 1;
+        pthread_mutex_unlock(&cache_mutex);
+        
+        dprintf(fd, "OK %d %lld %lld computed %.6f\n", size, job.solutions, job.uniques, elapsed);
+    } else if (strcmp(command, "ENUM") == 0) {
+        int size;
+        long long limit = 0;
+        int fields = sscanf(args, "%d %lld", &size, &limit);
+        if (fields < 1 || size < 1 || size > MAX_SERVER_N || limit < 0) {
+            dprintf(fd, "ERR ENUM needs N between 1 and %d and an optional LIMIT\n", MAX_SERVER_N);
+            return 1;
+        }
+        
+        BatchJob job;
+        run_server_job(&job, size, fd, fd, limit);
+        if (job.cancelled) {
+            return 0;
+        }
+        dprintf(fd, "END %lld %lld\n", job.solutions, job.uniques);
+    } else if (strcmp(command, "VERIFY") == 0) {
+        int capacity = 16;
+        int size = 0;
+        int *placement = (int *)malloc(capacity * sizeof(int));
+        char *p = args;
+        char *end;
+        for (long value = strtol(p, &end, 10); end != p; value = strtol(p, &end, 10)) {
+            if (size >= capacity) {
+                capacity *= 2;
+                placement = (int *)realloc(placement, capacity * sizeof(int));
+            }
+            // Anything that does not fit an int is out of range for every board size
+            placement[size++] = (value < 0 || value > INT_MAX) ? -1 : (int)value;
+            p = end;
+        }
+        
+        if (size == 0) {
+            dprintf(fd, "ERR VERIFY needs a placement c0 c1 ... c(N-1)\n");
+        } else {
+            uint64_t *bits = (uint64_t *)malloc(3 * VERIFY_WORDS(size) * sizeof(uint64_t));
+            const char *reason = verify_placement(placement, size, bits);
+            free(bits);
+            if (reason) {
+                dprintf(fd, "INVALID %s\n", reason);
+            } else {
+                dprintf(fd, "VALID %d\n", size);
+            }
+        }
+        free(placement);
+    } else if (strcmp(command, "PING") == 0) {
+        dprintf(fd, "PONG\n");
+    } else if (strcmp(command, "QUIT") == 0) {
+        return 0;
+    } else {
+        dprintf(fd, "ERR unknown command '%s'\n", command);
+    }
+    return 1;
+}
+
+/**
+ * Per-connection thread: read request lines until the client disconnects or sends QUIT
+ */
+void *client_thread(void *arg) {
+    int fd = (int)(long)arg;
+    FILE *in = fdopen(dup(fd), "r");
+    char *line = NULL;
+    size_t line_capacity = 0;
+    
+    while (in && getline(&line, &line_capacity, in) > 0) {
+        if (!handle_request(fd, line)) {
+            break;
+        }
+    }
+    
+    free(line);
+    if (in) {
+        fclose(in);
+    }
+    
+    // Deregister before closing so shutdown never touches a reused descriptor
+    pthread_mutex_lock(&clients_mutex);
+    for (int i = 0; i < num_client_fds; i++) {
+        if (client_fds[i] == fd) {
+            client_fds[i] = client_fds[--num_client_fds];
+            break;
+        }
+    }
+    pthread_cond_broadcast(&clients_changed);
+    pthread_mutex_unlock(&clients_mutex);
+    close(fd);
+    return NULL;
+}
+
+/**
+ * Signal handler for SIGINT/SIGTERM in server mode
+ */
+void stop_server(int sig) {
+    (void)sig;
+    __atomic_store_n(&server_running, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * Start a thread with SIGINT/SIGTERM blocked so only the accept loop sees them
+ */
+void start_thread_without_signals(pthread_t *thread, void *(*fn)(void *), void *arg) {
+    sigset_t block, previous;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &previous);
+    pthread_create(thread, NULL, fn, arg);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+}
+
+/**
+ * Server mode: keep a warm thread pool and count cache, and answer
+ * COUNT / ENUM / VERIFY requests over a Unix domain socket
+ */
+int run_server(int actual_threads, const char *socket_path) {
+    struct sockaddr_un addr;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path '%s' is too long\n", socket_path);
+        return 1;
+    }
+    
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 64) < 0) {
+        perror(socket_path);
+        close(listen_fd);
+        return 1;
+    }
+    
+    // Queue slots and worker boards are sized for the largest board a request may ask for
+    n = MAX_SERVER_N;
+    init_work_queue((queue_size > 0) ? queue_size : 64 * actual_threads);
+    init_queue_slots(&priority_queue, work_queue.capacity);
+    
+    pthread_t *threads = (pthread_t *)malloc(actual_threads * sizeof(pthread_t));
+    for (int i = 0; i < actual_threads; i++) {
+        start_thread_without_signals(&threads[i], thread_worker, NULL);
+    }
+    
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_server;  // No SA_RESTART, so accept() returns EINTR
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    
+    printf("Listening on %s (COUNT N | ENUM N [LIMIT] | VERIFY c0 c1 ... | PING | QUIT)\n", socket_path);
+    fflush(stdout);
+    
+    while (__atomic_load_n(&server_running, __ATOMIC_RELAXED)) {
+        int client_fd = accept(listen_fd, NULL, NULL);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("accept");
+            break;
+        }
+        
+        pthread_mutex_lock(&clients_mutex);
+        if (num_client_fds >= client_fds_capacity) {
+            client_fds_capacity = client_fds_capacity ? client_fds_capacity * 2 : 16;
+            client_fds = (int *)realloc(client_fds, client_fds_capacity * sizeof(int));
+        }
+        client_fds[num_client_fds++] = client_fd;
+        pthread_mutex_unlock(&clients_mutex);
+        
+        pthread_t client;
+        start_thread_without_signals(&client, client_thread, (void *)(long)client_fd);
+        pthread_detach(client);
+    }
+    
+    close(listen_fd);
+    unlink(socket_path);
+    __atomic_store_n(&server_running, 0, __ATOMIC_RELAXED);
+    
+    // Wake every client (idle ones see EOF, busy ones cancel their job) and wait
+    // for them to finish producing before the queue is torn down
+    pthread_mutex_lock(&clients_mutex);
+    for (int i = 0; i < num_client_fds; i++) {
+        shutdown(client_fds[i], SHUT_RDWR);
+    }
+    while (num_client_fds > 0) {
+        pthread_cond_wait(&clients_changed, &clients_mutex);
+    }
+    pthread_mutex_unlock(&clients_mutex);
+    free(client_fds);
+    
+    // Let the workers drain anything still queued, then shut the pool down
+    close_work_queue();
+    for (int i = 0; i < actual_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    printf("\nServed %ld request(s), %ld count cache hit(s)\n", requests_served, cache_hits);
+    
+    free(threads);
+    free_work_queue();
+    return 0;
+}
+
+/**
+ * Read the next text record: the integers on one line, skipping any other tokens
+ * (so "SOL U 0 4 7 ..." lines from the daemon are accepted as-is); a token counts
+ * as an integer only if it is all digits, so "12abc" is skipped rather than read as 12
+ * Returns the number of columns read, 0 for a blank line, or -1 at end of input;
+ * malformed is set for negative columns or boards larger than MAX_RECORD_N
+ */
+int read_text_record(FILE *in, unsigned char *cells, int *malformed) {
+    int size = 0;
+    int value = -1;  // Digits of the current number (-1 = not inside a number)
+    int in_other_token = 0;
+    int c;
+    
+    *malformed = 0;
+    while ((c = fgetc(in)) != EOF && c != '\n') {
+        if (c >= '0' && c <= '9') {
+            if (!in_other_token) {
+                value = (value < 0 ? 0 : value * 10) + (c - '0');
+                if (value > MAX_RECORD_N) {
+                    value = MAX_RECORD_N;  // Clamped; flagged as out of range below
+                }
+            }
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == ',' || c == '\r' || c == '#') {
+            if (value >= 0) {
+                if (size < MAX_RECORD_N) {
+                    cells[size] = (unsigned char)value;
+                }
+                size++;
+            }
+            value = -1;
+            in_other_token = 0;
+            if (c == '#') {
+                while ((c = fgetc(in)) != EOF && c != '\n') {
+                }
+                break;
+            }
+            continue;
+        }
+        
+        // Any other character makes the whole token a skipped word, so "12abc" is not 12
+        if (c == '-' && !in_other_token && value < 0) {
+            *malformed = 1;  // Negative column
+        }
+        value = -1;
+        in_other_token = 1;
+    }
+    if (value >= 0) {
+        if (size < MAX_RECORD_N) {
+            cells[size] = (unsigned char)value;
+        }
+        size++;
+    }
+    
+    if (size > MAX_RECORD_N) {
+        *malformed = 1;
+        size = MAX_RECORD_N;
+    }
+    if (c == EOF && size == 0) {
+        return -1;
+    }
+    return size;
+}
+
+/**
+ * Look up a canonical board in the class table, adding it with count 0 if new
+ */
+ClassEntry *find_or_add_class(const unsigned char *cells, int size) {
+    unsigned long long hash = 1469598103934665603ULL;  // FNV-1a
+    hash = (hash ^ (unsigned)size) * 1099511628211ULL;
+    for (int i = 0; i < size; i++) {
+        hash = (hash ^ cells[i]) * 1099511628211ULL;
+    }
+    
+    ClassShard *shard = &class_shards[hash % CLASS_SHARDS];
+    pthread_mutex_lock(&shard->mutex);
+    
+    if (shard->num_buckets == 0 || shard->size >= shard->num_buckets) {
+        // Grow and rehash once the load factor reaches 1
+        int num_buckets = shard->num_buckets ? shard->num_buckets * 2 : 64;
+        ClassEntry **buckets = (ClassEntry **)calloc(num_buckets, sizeof(ClassEntry *));
+        for (int i = 0; i < shard->num_buckets; i++) {
+            ClassEntry *entry = shard->buckets[i];
+            while (entry) {
+                ClassEntry *next = entry->next;
+                int slot = (entry->hash / CLASS_SHARDS) % num_buckets;
+                entry->next = buckets[slot];
+                buckets[slot] = entry;
+                entry = next;
+            }
+        }
+        free(shard->buckets);
+        shard->buckets = buckets;
+        shard->num_buckets = num_buckets;
+    }
+    
+    int slot = (hash / CLASS_SHARDS) % shard->num_buckets;
+    ClassEntry *entry = shard->buckets[slot];
+    while (entry && !(entry->hash == hash && entry->n == size &&
+                      memcmp(entry->cells, cells, size) == 0)) {
+        entry = entry->next;
+    }
+    if (!entry) {
+        entry = (ClassEntry *)malloc(sizeof(ClassEntry) + size);
+        entry->hash = hash;
+        entry->n = size;
+        entry->count = 0;
+        memcpy(entry->cells, cells, size);
+        entry->next = shard->buckets[slot];
+        shard->buckets[slot] = entry;
+        shard->size++;
+    }
+    entry->count++;
+    
+    pthread_mutex_unlock(&shard->mutex);
+    return entry;
+}
+
+/**
+ * Take a batch index from a free or full list, blocking until one is available
+ * With wait_for_close set, returns -1 once the list is empty and the reader is done
+ */
+int pop_batch_index(int *list, int *count, pthread_cond_t *cond, int wait_for_close) {
+    pthread_mutex_lock(&batch_mutex);
+    while (*count == 0 && !(wait_for_close && batches_closed)) {
+        pthread_cond_wait(cond, &batch_mutex);
+    }
+    int index = (*count > 0) ? list[--(*count)] : -1;
+    pthread_mutex_unlock(&batch_mutex);
+    return index;
+}
+
+/**
+ * Return a batch index to a free or full list and wake one waiter
+ */
+void push_batch_index(int *list, int *count, pthread_cond_t *cond, int index) {
+    pthread_mutex_lock(&batch_mutex);
+    list[(*count)++] = index;
+    pthread_cond_signal(cond);
+    pthread_mutex_unlock(&batch_mutex);
+}
+
+/**
+ * Canonicalizer worker: validate each record in O(N) and count it under its D4 class
+ */
+void *canonicalize_worker(void *arg) {
+    (void)arg;
+    board = (int *)malloc(MAX_RECORD_N * sizeof(int));
+    scratch = (int *)malloc(MAX_RECORD_N * sizeof(int));
+    int *best = (int *)malloc(MAX_RECORD_N * sizeof(int));
+    unsigned char *key = (unsigned char *)malloc(MAX_RECORD_N);
+    uint64_t *bits = (uint64_t *)malloc(3 * VERIFY_WORDS(MAX_RECORD_N) * sizeof(uint64_t));
+    long valid = 0;
+    long invalid = 0;
     
-    // Generate all partial boards up to parallelization depth
-    int *partial_board = (int *)malloc(n * sizeof(int));
-    memset(partial_board, -1, n * sizeof(int));
-    generate_work_queue(0, partial_board);
-    free(partial_board);
+    while (1) {
+        int index = pop_batch_index(full_batches, &num_full_batches, &batch_filled, 1);
+        if (index < 0) {
+            break;  // Reader finished and every batch has been processed
+        }
+        RecordBatch *batch = &record_batches[index];
+        
+        for (int r = 0; r < batch->count; r++) {
+            int size = batch->sizes[r];
+            const unsigned char *cells = &batch->cells[r * MAX_RECORD_N];
+            const char *reason = NULL;
+            
+            if (size < 0) {
+                reason = "malformed record or board too large";
+            } else {
+                for (int row = 0; row < size; row++) {
+                    board[row] = cells[row];
+                }
+                reason = verify_placement(board, size, bits);
+            }
+            if (reason) {
+                invalid++;
+                if (__atomic_add_fetch(&reported_invalid, 1, __ATOMIC_RELAXED) <= 10) {
+                    if (binary_records) {
+                        fprintf(stderr, "Record %ld: INVALID (%s)\n", batch->first_record + r + 1, reason);
+                    } else {
+                        fprintf(stderr, "Line %ld: INVALID (%s)\n", batch->lines[r], reason);
+                    }
+                }
+                continue;
+            }
+            valid++;
+            
+            // Canonical form: lexicographically smallest of the 8 symmetric variants
+            memcpy(best, board, size * sizeof(int));
+            for (int t = 1; t < 8; t++) {
+                apply_symmetry(t, board, scratch, size);
+                if (compare_boards(scratch, best, size) < 0) {
+                    memcpy(best, scratch, size * sizeof(int));
+                }
+            }
+            for (int row = 0; row < size; row++) {
+                key[row] = (unsigned char)best[row];
+            }
+            find_or_add_class(key, size);
+        }
+        
+        push_batch_index(free_batches, &num_free_batches, &batch_emptied, index);
+    }
+    
+    __atomic_add_fetch(&records_valid, valid, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&records_invalid, invalid, __ATOMIC_RELAXED);
+    free(bits);
+    free(key);
+    free(best);
+    free(scratch);
+    free(board);
+    return NULL;
+}
+
+/**
+ * Order classes by board size, then lexicographically
+ */
+int compare_classes(const void *a, const void *b) {
+    const ClassEntry *x = *(const ClassEntry * const *)a;
+    const ClassEntry *y = *(const ClassEntry * const *)b;
+    if (x->n != y->n) {
+        return x->n - y->n;
+    }
+    return memcmp(x->cells, y->cells, x->n);
+}
+
+/**
+ * Canonicalizer mode: stream solutions from a file (or stdin), validate each one,
+ * fold it into its symmetry class and print every class with its multiplicity
+ * Memory is bounded by the batch pool plus one entry per distinct class
+ */
+int run_canonicalize(int actual_threads, const char *path, int binary, int record_size) {
+    FILE *in = (strcmp(path, "-") == 0) ? stdin : fopen(path, binary ? "rb" : "r");
+    if (!in) {
+        fprintf(stderr, "Error: Cannot open '%s'\n", path);
+        return 1;
+    }
+    if (binary && record_size > MAX_RECORD_N) {
+        fprintf(stderr, "Error: Binary records support N up to %d\n", MAX_RECORD_N);
+        return 1;
+    }
+    
+    for (int i = 0; i < CLASS_SHARDS; i++) {
+        pthread_mutex_init(&class_shards[i].mutex, NULL);
+    }
+    
+    num_record_batches = 2 * actual_threads;
+    record_batches = (RecordBatch *)malloc(num_record_batches * sizeof(RecordBatch));
+    free_batches = (int *)malloc(num_record_batches * sizeof(int));
+    full_batches = (int *)malloc(num_record_batches * sizeof(int));
+    for (int i = 0; i < num_record_batches; i++) {
+        record_batches[i].cells = (unsigned char *)malloc(RECORD_BATCH_SIZE * MAX_RECORD_N);
+        record_batches[i].sizes = (int *)malloc(RECORD_BATCH_SIZE * sizeof(int));
+        record_batches[i].lines = (long *)malloc(RECORD_BATCH_SIZE * sizeof(long));
+        free_batches[num_free_batches++] = i;
+    }
+    
+    double start = wall_time();
+    pthread_t *threads = (pthread_t *)malloc(actual_threads * sizeof(pthread_t));
+    for (int i = 0; i < actual_threads; i++) {
+        pthread_create(&threads[i], NULL, canonicalize_worker, NULL);
+    }
+    
+    // Reader: fill batches from the stream while the workers drain them
+    long records_read = 0;
+    long lines_read = 0;  // Each read_text_record call consumes one line
+    int end_of_input = 0;
+    while (!end_of_input) {
+        int index = pop_batch_index(free_batches, &num_free_batches, &batch_emptied, 0);
+        RecordBatch *batch = &record_batches[index];
+        batch->first_record = records_read;
+        batch->count = 0;
+        
+        while (batch->count < RECORD_BATCH_SIZE) {
+            unsigned char *cells = &batch->cells[batch->count * MAX_RECORD_N];
+            int size;
+            if (binary) {
+                size = (int)fread(cells, 1, record_size, in);
+                if (size < record_size) {
+                    if (size > 0) {
+                        fprintf(stderr, "Warning: Ignoring %d trailing byte(s)\n", size);
+                    }
+                    end_of_input = 1;
+                    break;
+                }
+            } else {
+                int malformed;
+                size = read_text_record(in, cells, &malformed);
+                if (size < 0) {
+                    end_of_input = 1;
+                    break;
+                }
+                lines_read++;
+                batch->lines[batch->count] = lines_read;
+                if (size == 0) {
+                    continue;  // Blank or comment line
+                }
+                if (malformed) {
+                    size = -1;
+                }
+            }
+            batch->sizes[batch->count++] = size;
+            records_read++;
+        }
+        
+        push_batch_index(full_batches, &num_full_batches, &batch_filled, index);
+    }
+    
+    pthread_mutex_lock(&batch_mutex);
+    batches_closed = 1;
+    pthread_cond_broadcast(&batch_filled);
+    pthread_mutex_unlock(&batch_mutex);
+    
+    for (int i = 0; i < actual_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = wall_time() - start;
+    if (in != stdin) {
+        fclose(in);
+    }
+    
+    // Gather and sort the classes for stable output
+    long num_classes = 0;
+    for (int i = 0; i < CLASS_SHARDS; i++) {
+        num_classes += class_shards[i].size;
+    }
+    ClassEntry **classes = (ClassEntry **)malloc((num_classes + 1) * sizeof(ClassEntry *));
+    long k = 0;
+    for (int i = 0; i < CLASS_SHARDS; i++) {
+        for (int b = 0; b < class_shards[i].num_buckets; b++) {
+            for (ClassEntry *entry = class_shards[i].buckets[b]; entry; entry = entry->next) {
+                classes[k++] = entry;
+            }
+        }
+    }
+    qsort(classes, num_classes, sizeof(ClassEntry *), compare_classes);
+    
+    if (print_solutions) {
+        for (long i = 0; i < num_classes; i++) {
+            printf("Class #%ld (N=%d) x%lld:", i + 1, classes[i]->n, classes[i]->count);
+            for (int row = 0; row < classes[i]->n; row++) {
+                printf(" %d", classes[i]->cells[row]);
+            }
+            printf("\n");
+        }
+    }
+    
+    printf("\nTime: %.6f seconds\n", elapsed);
+    printf("\n╔════════════════════════════════════════════════════════════╗\n");
+    printf("║ Records read:                   %-27ld║\n", records_read);
+    printf("║ Valid solutions:                %-27ld║\n", records_valid);
+    printf("║ Invalid records:                %-27ld║\n", records_invalid);
+    printf("║ Unique classes (no symmetry):   %-27ld║\n", num_classes);
+    printf("╚════════════════════════════════════════════════════════════╝\n");
+    
+    // Cleanup
+    for (long i = 0; i < num_classes; i++) {
+        free(classes[i]);
+    }
+    free(classes);
+    for (int i = 0; i < CLASS_SHARDS; i++) {
+        free(class_shards[i].buckets);
+        pthread_mutex_destroy(&class_shards[i].mutex);
+    }
+    for (int i = 0; i < num_record_batches; i++) {
+        free(record_batches[i].cells);
+        free(record_batches[i].sizes);
+        free(record_batches[i].lines);
+    }
+    free(record_batches);
+    free(free_batches);
+    free(full_batches);
+    free(threads);
+    return records_invalid > 0 ? 2 : 0;
+}
+
+/**
+ * Build one solution directly using the explicit construction for N >= 4:
+ * even columns then odd columns, with adjustments when N mod 6 is 2 or 3
+ * Returns 1 on success, 0 if no solution exists for this N (2 and 3)
+ */
+int construct_solution(int *b) {
+    if (n == 1) {
+        b[0] = 0;
+        return 1;
+    }
+    if (n < 4) {
+        return 0;
+    }
+    
+    int row = 0;
+    int rem = n % 6;
+    
+    // Even columns (1-based): 2, 4, 6, ... with 2 moved to the end when N mod 6 == 3
+    if (rem == 3) {
+        for (int col = 4; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+        b[row++] = 1;
+    } else {
+        for (int col = 2; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+    }
+    
+    // Odd columns (1-based): 1, 3, 5, ... reordered when N mod 6 is 2 or 3
+    if (rem == 2) {
+        b[row++] = 2;
+        b[row++] = 0;
+        for (int col = 7; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+        b[row++] = 4;
+    } else if (rem == 3) {
+        for (int col = 5; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+        b[row++] = 0;
+        b[row++] = 2;
+    } else {
+        for (int col = 1; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Constructive fast path: produce a single solution without any search
+ */
+int run_construct(void) {
+    board = (int *)malloc(n * sizeof(int));
+    
+    double start = wall_time();
+    int found = construct_solution(board);
+    double elapsed = wall_time() - start;
+    
+    if (found && print_solutions) {
+        if (n <= 64) {
+            print_solution(board, 1);
+        } else {
+            // Too wide to draw, so give the column of each row's queen on one line
+            printf("\nSolution #1 (columns, row 0 first):\n");
+            for (int row = 0; row < n; row++) {
+                printf(row ? " %d" : "%d", board[row]);
+            }
+            printf("\n");
+        }
+    }
+    
+    printf("\nTime: %.6f seconds (%.1f microseconds)\n", elapsed, elapsed * 1e6);
+    
+    printf("\n╔════════════════════════════════════════════════════════════╗\n");
+    printf("║ Constructed solution:           %-27s║\n", found ? "YES" : "NO (none exist)");
+    printf("╚════════════════════════════════════════════════════════════╝\n");
+    
+    free(board);
+    return found ? 0 : 1;
+}
+
+/**
+ * Print usage information
+ */
+void print_usage(const char *program_name) {
+    printf("Usage: %s [OPTIONS]\n\n", program_name);
+    printf("Solve the N-Queens problem using multi-threaded backtracking with symmetry detection.\n\n");
+    printf("OPTIONS:\n");
+    printf("  n [N]              Board size (default: 8)\n");
+    printf("  --threads NUM      Number of threads to use (default: auto-detect)\n");
+    printf("  --quiet            Don't print intermediate solutions, only final summary\n");
+    printf("  --progress         Show progress bar during solving\n");
+    printf("  --queue-size NUM   Bounded work queue capacity (default: 64 per thread)\n");
+    printf("  --limit K          Stop after the first K solutions\n");
+    printf("  --limit-unique K   Stop after the first K unique solutions\n");
+    printf("  --first            Stop after the first solution (same as --limit 1)\n");
+    printf("  --construct        Build one solution directly without searching (any N)\n");
+    printf("  --place ROW,COL    Require a queen at ROW,COL (0-based, repeatable)\n");
+    printf("  --block ROW,COL    Forbid a queen at ROW,COL (0-based, repeatable)\n");
+    printf("  --constraints FILE Read 'Q ROW COL' / 'X ROW COL' lines from FILE\n");
+    printf("  --batch LIST       Solve several sizes (e.g. 4-16 or 4,6,8, up to %d) and print one table\n", MAX_BATCH_N);
+    printf("  --serve PATH       Run as a daemon answering requests on a Unix socket\n");
+    printf("  --canonicalize FILE  Validate solutions from FILE (- = stdin), one per line,\n");
+    printf("                     and print each symmetry class with its multiplicity\n");
+    printf("  --binary           With --canonicalize: input is raw N-byte records (N from n)\n");
+    printf("  --help             Show this help message\n\n");
+    printf("EXAMPLES:\n");
+    printf("  %s                    # Solve 8-queens with auto-detected threads\n", program_name);
+    printf("  %s 10                 # Solve 10-queens\n", program_name);
+    printf("  %s 8 --threads 4      # Solve 8-queens using exactly 4 threads\n", program_name);
+    printf("  %s 12 --progress      # Solve 12-queens and show progress\n", program_name);
+    printf("  %s 12 --threads 8 --quiet --progress  # All options\n", program_name);
+    printf("  %s 20 --first --quiet  # Find one 20-queens solution and stop\n", program_name);
+    printf("  %s 1000000 --construct  # Witness for a huge board, as one line of columns\n", program_name);
+    printf("  %s 8 --place 0,3 --block 7,7  # Complete a partial placement\n", program_name);
+    printf("  %s --batch 4-16       # Sweep several sizes on one thread pool\n", program_name);
+    printf("  %s --serve /tmp/queens.sock  # Serve COUNT/ENUM/VERIFY requests\n", program_name);
+    printf("  %s --canonicalize solutions.txt --quiet  # Validate and dedupe a solution list\n", program_name);
+}
+
+int main(int argc, char *argv[]) {
+    n = 8;
+    num_threads = 0;  // 0 means auto-detect
+    print_solutions = 1;  // 1 means print solutions
+    
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--quiet") == 0 || strcmp(argv[i], "-q") == 0) {
+            print_solutions = 0;
+        } else if (strcmp(argv[i], "--progress") == 0 || strcmp(argv[i], "-p") == 0) {
+            show_progress = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) {
+            if (i + 1 < argc) {
+                num_threads = atoi(argv[++i]);
+                if (num_threads < 1) {
+                    fprintf(stderr, "Error: Thread count must be at least 1\n");
+                    return 1;
+                }
+            } else {
+                fprintf(stderr, "Error: --threads requires a number argument\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--queue-size") == 0) {
+            if (i + 1 < argc) {
+                queue_size = atoi(argv[++i]);
+                if (queue_size < 1) {
+                    fprintf(stderr, "Error: Queue size must be at least 1\n");
+                    return 1;
+                }
+            } else {
+                fprintf(stderr, "Error: --queue-size requires a number argument\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--limit") == 0 || strcmp(argv[i], "--limit-unique") == 0) {
+            if (i + 1 < argc) {
+                int *target = (strcmp(argv[i], "--limit") == 0) ? &solution_limit : &unique_limit;
+                *target = atoi(argv[++i]);
+                if (*target < 1) {
+                    fprintf(stderr, "Error: Limit must be at least 1\n");
+                    return 1;
+                }
+            } else {
+                fprintf(stderr, "Error: %s requires a number argument\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--first") == 0) {
+            solution_limit = 1;
+        } else if (strcmp(argv[i], "--construct") == 0) {
+            use_construct = 1;
+        } else if (strcmp(argv[i], "--place") == 0 || strcmp(argv[i], "--block") == 0) {
+            int row, col;
+            if (i + 1 >= argc || !parse_cell(argv[i + 1], &row, &col)) {
+                fprintf(stderr, "Error: %s requires a ROW,COL argument\n", argv[i]);
+                return 1;
+            }
+            add_constraint(row, col, strcmp(argv[i], "--place") == 0);
+            i++;
+        } else if (strcmp(argv[i], "--constraints") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --constraints requires a file argument\n");
+                return 1;
+            }
+            if (load_constraints_file(argv[++i]) != 0) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --serve requires a socket path\n");
+                return 1;
+            }
+            serve_path = argv[++i];
+        } else if (strcmp(argv[i], "--canonicalize") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --canonicalize requires a file argument (- for stdin)\n");
+                return 1;
+            }
+            canonicalize_path = argv[++i];
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            binary_records = 1;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            if (i + 1 >= argc || parse_batch_spec(argv[i + 1]) != 0) {
+                fprintf(stderr, "Error: --batch requires a list of sizes up to %d such as 4-16 or 4,6,8\n", MAX_BATCH_N);
+                return 1;
+            }
+            i++;
+        } else if (argv[i][0] != '-') {
+            // Positional argument - board size
+            n = atoi(argv[i]);
+            if (n < 1) {
+                fprintf(stderr, "Error: N must be at least 1\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    // Reject mode conflicts before the n*n mask is allocated
+    if (num_constraints > 0 && use_construct) {
+        fprintf(stderr, "Error: --construct cannot be combined with --place/--block/--constraints\n");
+        return 1;
+    }
+    
+    if (num_batch_jobs > 0 && (num_constraints > 0 || use_construct || solution_limit > 0 || unique_limit > 0)) {
+        fprintf(stderr, "Error: --batch cannot be combined with constraints, limits or --construct\n");
+        return 1;
+    }
+    if (canonicalize_path && (serve_path || num_batch_jobs > 0 || num_constraints > 0 || use_construct ||
+                              solution_limit > 0 || unique_limit > 0)) {
+        fprintf(stderr, "Error: --canonicalize cannot be combined with other modes, constraints or limits\n");
+        return 1;
+    }
+    if (serve_path && (num_batch_jobs > 0 || num_constraints > 0 || use_construct || solution_limit > 0 || unique_limit > 0)) {
+        fprintf(stderr, "Error: --serve cannot be combined with --batch, constraints, limits or --construct\n");
+        return 1;
+    }
+    if (build_allowed_mask() != 0) {
+        return 1;
+    }
+    
+    // Detect number of CPU cores
+    num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_cores < 1) {
+        num_cores = 1;
+    }
+    
+    // Use user-specified thread count or auto-detected cores
+    int actual_threads = (num_threads > 0) ? num_threads : num_cores;
+    
+    if (num_batch_jobs > 0) {
+        printf("╔════════════════════════════════════════════════════════════╗\n");
+        printf("║  BATCH MODE: %3d board size(s) on one thread pool          ║\n", num_batch_jobs);
+        printf("║  Unique counts account for rotation and reflection         ║\n");
+        printf("║  Detected %d CPU core(s) | Using %d thread(s)               ║\n",
+               num_cores, actual_threads);
+        printf("╚════════════════════════════════════════════════════════════╝\n\n");
+        return run_batch(actual_threads);
+    }
+    
+    if (canonicalize_path) {
+        printf("╔════════════════════════════════════════════════════════════╗\n");
+        printf("║  CANONICALIZER: validate and group solutions by symmetry   ║\n");
+        printf("║  Input: %-10s | Using %d thread(s)                      ║\n",
+               binary_records ? "binary" : "text", actual_threads);
+        printf("╚════════════════════════════════════════════════════════════╝\n\n");
+        return run_canonicalize(actual_threads, canonicalize_path, binary_records, n);
+    }
     
-    // Set total work items for progress tracking
-    total_work_items = work_queue.size;
+    if (serve_path) {
+        printf("╔════════════════════════════════════════════════════════════╗\n");
+        printf("║  SERVER MODE: warm thread pool and count cache             ║\n");
+        printf("║  Boards up to N=%d | Using %d thread(s)                     ║\n",
+               MAX_SERVER_N, actual_threads);
+        printf("╚════════════════════════════════════════════════════════════╝\n\n");
+        return run_server(actual_threads, serve_path);
+    }
+    
+    solution_set.capacity = 1000;
+    solution_set.solutions = (char **)malloc(solution_set.capacity * sizeof(char *));
+    solution_set.unique_ids = (int *)malloc(solution_set.capacity * sizeof(int));
+    solution_set.size = 0;
+    
+    printf("╔════════════════════════════════════════════════════════════╗\n");
+    printf("║  UNIQUE SOLUTIONS (ACCOUNTING FOR SYMMETRY)  QUEENS-%3d    ║\n", n);
+    printf("║  Solutions that are the same after rotation or reflection  ║\n");
+    printf("║  are counted as one unique solution                        ║\n");
+    printf("║  Detected %d CPU core(s)                                   ║\n", num_cores);
+    printf("║  Using %d thread(s) | %s intermediate solutions           ║\n", 
+           actual_threads, print_solutions ? "Printing" : "Suppressing");
+    printf("╚════════════════════════════════════════════════════════════╝\n\n");
+    
+    if (use_construct) {
+        return run_construct();
+    }
+    
+    clock_t start = clock();
+    start_wall = wall_time();
+    
+    // Calculate parallelization depth
+    parallelization_depth = depth_for_size(n);
+    
+    // Initialize the bounded work queue
+    init_work_queue((queue_size > 0) ? queue_size : 64 * actual_threads);
     
-    printf("║  Parallelization depth: %d | Work items: %d           ║\n", 
-           parallelization_depth, work_queue.size);
+    printf("║  Parallelization depth: %d | Queue capacity: %d       ║\n", 
+           parallelization_depth, work_queue.capacity);
+    if (allowed) {
+        printf("║  Constraints: %d pre-placed queen(s), %d rule(s)          ║\n",
+               num_fixed_queens, num_constraints);
+    }
     if (show_progress) {
         printf("║  Progress tracking: ENABLED                               ║\n");
     }
@@ -492,6 +2217,14 @@ int main(int argc, char *argv[]) {
         thread_created[i] = 1;
     }
     
+    // Produce partial boards up to parallelization depth on this thread;
+    // workers start solving as soon as the first item lands in the queue
+    int *partial_board = (int *)malloc(n * sizeof(int));
+    memset(partial_board, -1, n * sizeof(int));
+    generate_work_queue(0, partial_board);
+    free(partial_board);
+    close_work_queue();
+    
     // Wait for all created threads to complete
     for (int i = 0; i < actual_threads; i++) {
         if (thread_created[i]) {
@@ -506,8 +2239,16 @@ int main(int argc, char *argv[]) {
     
     clock_t end = clock();
     double elapsed = (double)(end - start) / CLOCKS_PER_SEC;
+    double elapsed_wall = wall_time() - start_wall;
     
     printf("\nTime: %.6f seconds\n", elapsed);
+    printf("Wall time: %.6f seconds | Work items: %d\n", elapsed_wall, total_work_items);
+    if (first_solution_wall >= 0.0) {
+        printf("Time to first solution: %.6f seconds\n", first_solution_wall - start_wall);
+    }
+    if (search_stopped()) {
+        printf("Requested limit reached: the search stopped there without checking for more solutions\n");
+    }
     
     printf("\n╔════════════════════════════════════════════════════════════╗\n");
     printf("║ Total solutions found:          %-27d║\n", solutions_count);
@@ -524,12 +2265,11 @@ int main(int argc, char *argv[]) {
     }
     free(solution_set.solutions);
     free(solution_set.unique_ids);
+    free(constraints);
+    free(allowed);
     
     // Cleanup work queue
-    for (int i = 0; i < work_queue.size; i++) {
-        free(work_queue.items[i].board);
-    }
-    free(work_queue.items);
+    free_work_queue();
     
     free(threads);
     free(thread_created);
@@ -539,6 +2279,8 @@ int main(int argc, char *argv[]) {
     pthread_mutex_destroy(&data_mutex);
     pthread_mutex_destroy(&progress_mutex);
     pthread_mutex_destroy(&queue_mutex);
+    pthread_cond_destroy(&queue_not_empty);
+    pthread_cond_destroy(&queue_not_full);
     
     return 0;
 }
@@ -7,6 +7,17 @@ int n;
 int *board;
 int solutions_count = 0;
 int unique_count = 0;
+int solution_limit = 0;  // Stop after this many solutions (0 = no limit)
+int unique_limit = 0;  // Stop after this many unique solutions (0 = no limit)
+int use_construct = 0;  // 1 = build one solution directly instead of searching
+int stop_search = 0;  // Set once a limit is reached
+int emit_orbits = 0;  // 1 = search canonical representatives only and expand their orbits
+
+// Names of the transforms applied by apply_symmetry, used to tag orbit variants
+const char *symmetry_names[8] = {
+    "identity", "rotated 90°", "rotated 180°", "rotated 270°",
+    "flipped horizontally", "flipped vertically", "flipped on main diagonal", "flipped on anti-diagonal"
+};
 
 // Hash set to store canonical solutions with their unique ID
 typedef struct {
@@ -18,6 +29,19 @@ typedef struct {
 
 SolutionSet solution_set;
 
+// Pre-placed queen or forbidden cell supplied by the user
+typedef struct {
+    int row;
+    int col;
+    int is_queen;  // 1 = queen must be here, 0 = no queen may be here
+} Constraint;
+
+Constraint *constraints = NULL;
+int num_constraints = 0;
+int constraints_capacity = 0;
+int num_fixed_queens = 0;
+char *allowed = NULL;  // n*n mask of cells a queen may occupy (NULL = unconstrained)
+
 /**
  * Convert a board configuration to a string for comparison
  */
@@ -45,6 +69,27 @@ char *min_string(char *s1, char *s2) {
     }
 }
 
+/**
+ * Apply symmetry transform t to a board of the given size
+ * 0 = identity, 1-3 = rotations by 90/180/270° clockwise, 4-7 = horizontal,
+ * vertical, main-diagonal and anti-diagonal flips
+ */
+void apply_symmetry(int t, const int *b, int *out, int size) {
+    for (int row = 0; row < size; row++) {
+        int col = b[row];
+        switch (t) {
+            case 0: out[row] = col; break;  // Identity
+            case 1: out[col] = size - 1 - row; break;  // (row, col) -> (col, n-1-row)
+            case 2: out[size - 1 - row] = size - 1 - col; break;  // (row, col) -> (n-1-row, n-1-col)
+            case 3: out[size - 1 - col] = row; break;  // (row, col) -> (n-1-col, row)
+            case 4: out[row] = size - 1 - col; break;  // (row, col) -> (row, n-1-col)
+            case 5: out[size - 1 - row] = col; break;  // (row, col) -> (n-1-row, col)
+            case 6: out[col] = row; break;  // (row, col) -> (col, row)
+            case 7: out[size - 1 - col] = size - 1 - row; break;  // (row, col) -> (n-1-col, n-1-row)
+        }
+    }
+}
+
 /**
  * Apply transformations to generate all 8 symmetries
  * and return the lexicographically smallest one (canonical form)
@@ -53,54 +98,10 @@ char *get_canonical_form(int *b) {
     int *temp = (int *)malloc(n * sizeof(int));
     char *canonical = board_to_string(b);
     
-    // Rotation 90° clockwise: (row, col) -> (col, n-1-row)
-    for (int row = 0; row < n; row++) {
-        temp[b[row]] = n - 1 - row;  // If queen at (row, b[row]), new position: (b[row], n-1-row)
-    }
-    char *rotated90 = board_to_string(temp);
-    canonical = min_string(canonical, rotated90);
-    
-    // Rotation 180°: (row, col) -> (n-1-row, n-1-col)
-    for (int row = 0; row < n; row++) {
-        temp[n - 1 - b[row]] = n - 1 - row;
-    }
-    char *rotated180 = board_to_string(temp);
-    canonical = min_string(canonical, rotated180);
-    
-    // Rotation 270° clockwise: (row, col) -> (n-1-col, row)
-    for (int row = 0; row < n; row++) {
-        temp[n - 1 - b[row]] = row;
-    }
-    char *rotated270 = board_to_string(temp);
-    canonical = min_string(canonical, rotated270);
-    
-    // Horizontal flip: (row, col) -> (row, n-1-col)
-    for (int row = 0; row < n; row++) {
-        temp[row] = n - 1 - b[row];
-    }
-    char *flipped_h = board_to_string(temp);
-    canonical = min_string(canonical, flipped_h);
-    
-    // Vertical flip: (row, col) -> (n-1-row, col)
-    for (int row = 0; row < n; row++) {
-        temp[n - 1 - row] = b[row];
-    }
-    char *flipped_v = board_to_string(temp);
-    canonical = min_string(canonical, flipped_v);
-    
-    // Diagonal flip (main): (row, col) -> (col, row)
-    for (int row = 0; row < n; row++) {
-        temp[b[row]] = row;
+    for (int t = 1; t < 8; t++) {
+        apply_symmetry(t, b, temp, n);
+        canonical = min_string(canonical, board_to_string(temp));
     }
-    char *flipped_diag = board_to_string(temp);
-    canonical = min_string(canonical, flipped_diag);
-    
-    // Anti-diagonal flip: (row, col) -> (n-1-col, n-1-row)
-    for (int row = 0; row < n; row++) {
-        temp[n - 1 - b[row]] = n - 1 - row;
-    }
-    char *flipped_antidiag = board_to_string(temp);
-    canonical = min_string(canonical, flipped_antidiag);
     
     free(temp);
     return canonical;
@@ -135,6 +136,121 @@ void add_to_set(char *canonical, int unique_id) {
     solution_set.size++;
 }
 
+/**
+ * Record a pre-placed queen or forbidden cell (validated once N is known)
+ */
+void add_constraint(int row, int col, int is_queen) {
+    if (num_constraints >= constraints_capacity) {
+        constraints_capacity = (constraints_capacity > 0) ? constraints_capacity * 2 : 16;
+        constraints = (Constraint *)realloc(constraints, constraints_capacity * sizeof(Constraint));
+    }
+    constraints[num_constraints].row = row;
+    constraints[num_constraints].col = col;
+    constraints[num_constraints].is_queen = is_queen;
+    num_constraints++;
+}
+
+/**
+ * Parse a "ROW,COL" cell argument
+ * Returns 1 on success, 0 on malformed input
+ */
+int parse_cell(const char *text, int *row, int *col) {
+    char extra;
+    return sscanf(text, "%d,%d%c", row, col, &extra) == 2;
+}
+
+/**
+ * Load constraints from a file, one per line:
+ *   Q ROW COL   pre-placed queen
+ *   X ROW COL   forbidden cell
+ * Blank lines and lines starting with '#' are ignored
+ * Returns 0 on success, -1 on error
+ */
+int load_constraints_file(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot open constraints file '%s'\n", path);
+        return -1;
+    }
+    
+    char line[256];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char kind;
+        int row, col;
+        char *p = line;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') {
+            continue;
+        }
+        if (sscanf(p, " %c %d %d", &kind, &row, &col) != 3 ||
+            (kind != 'Q' && kind != 'q' && kind != 'X' && kind != 'x')) {
+            fprintf(stderr, "Error: %s:%d: expected 'Q ROW COL' or 'X ROW COL'\n", path, line_number);
+            fclose(file);
+            return -1;
+        }
+        add_constraint(row, col, kind == 'Q' || kind == 'q');
+    }
+    
+    fclose(file);
+    return 0;
+}
+
+/**
+ * Build the allowed-cell mask from the recorded constraints
+ * Every cell attacked by a pre-placed queen is ruled out, so the search
+ * only ever considers placements compatible with the fixed queens
+ * Returns 0 on success, -1 if the constraints are out of range or contradictory
+ */
+int build_allowed_mask(void) {
+    if (num_constraints == 0) {
+        return 0;
+    }
+    
+    allowed = (char *)malloc((size_t)n * n);
+    if (!allowed) {
+        fprintf(stderr, "Error: Not enough memory for the %dx%d constraint mask\n", n, n);
+        return -1;
+    }
+    memset(allowed, 1, (size_t)n * n);
+    
+    for (int i = 0; i < num_constraints; i++) {
+        Constraint *c = &constraints[i];
+        if (c->row < 0 || c->row >= n || c->col < 0 || c->col >= n) {
+            fprintf(stderr, "Error: Cell (%d,%d) is outside the %dx%d board\n", c->row, c->col, n, n);
+            return -1;
+        }
+        if (!c->is_queen) {
+            allowed[(size_t)c->row * n + c->col] = 0;
+        }
+    }
+    
+    for (int i = 0; i < num_constraints; i++) {
+        Constraint *q = &constraints[i];
+        if (!q->is_queen) {
+            continue;
+        }
+        if (!allowed[(size_t)q->row * n + q->col]) {
+            fprintf(stderr, "Error: Queen at (%d,%d) is on a forbidden or attacked cell\n", q->row, q->col);
+            return -1;
+        }
+        for (int row = 0; row < n; row++) {
+            for (int col = 0; col < n; col++) {
+                if ((row == q->row) != (col == q->col) ||
+                    (row != q->row && abs(row - q->row) == abs(col - q->col))) {
+                    allowed[(size_t)row * n + col] = 0;
+                }
+            }
+        }
+        num_fixed_queens++;
+    }
+    
+    return 0;
+}
+
 /**
  * Print a solution
  */
@@ -156,6 +272,9 @@ void print_solution(int *b, int num) {
  * Check if it's safe to place a queen
  */
 int is_safe(int row, int col) {
+    if (allowed && !allowed[(size_t)row * n + col]) {
+        return 0;
+    }
     for (int i = 0; i < row; i++) {
         if (board[i] == col) {
             return 0;
@@ -199,10 +318,15 @@ void solve_nqueens(int row) {
                 print_solution(board, solutions_count);
             }
         }
+        
+        if ((solution_limit > 0 && solutions_count >= solution_limit) ||
+            (unique_limit > 0 && unique_count >= unique_limit)) {
+            stop_search = 1;
+        }
         return;
     }
     
-    for (int col = 0; col < n; col++) {
+    for (int col = 0; col < n && !stop_search; col++) {
         if (is_safe(row, col)) {
             board[row] = col;
             solve_nqueens(row + 1);
@@ -210,17 +334,228 @@ void solve_nqueens(int row) {
     }
 }
 
+/**
+ * Check whether a partial placement can still be the lexicographically smallest
+ * member of its symmetry class, using only the first element of each transform:
+ * row 0 stays in the left half (horizontal flip), and a queen in the first or last
+ * column, or in the last row, must not give a transform a smaller first element
+ */
+int is_canonical_prefix(int row, int col) {
+    if (row == 0) {
+        return col <= (n - 1) / 2;
+    }
+    int first = board[0];
+    if ((col == 0 || col == n - 1) && (row < first || n - 1 - row < first)) {
+        return 0;  // Rotations and diagonal flips would start with a smaller column
+    }
+    if (row == n - 1 && (col < first || n - 1 - col < first)) {
+        return 0;  // Vertical flip or 180° rotation would start with a smaller column
+    }
+    return 1;
+}
+
+/**
+ * Check whether a complete board is the lexicographically smallest of its 8 variants
+ */
+int is_canonical_board(int *b, int *temp) {
+    for (int t = 1; t < 8; t++) {
+        apply_symmetry(t, b, temp, n);
+        for (int row = 0; row < n; row++) {
+            if (temp[row] != b[row]) {
+                if (temp[row] < b[row]) {
+                    return 0;
+                }
+                break;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * Print a unique solution followed by every distinct member of its orbit,
+ * generated directly from the representative with the 8 symmetry transforms
+ */
+void emit_orbit(int *b) {
+    int *orbit = (int *)malloc(8 * n * sizeof(int));
+    int orbit_size = 0;
+    int transform_of[8];
+    
+    unique_count++;
+    for (int t = 0; t < 8; t++) {
+        int *variant = &orbit[orbit_size * n];
+        apply_symmetry(t, b, variant, n);
+        
+        // Symmetric representatives map onto themselves under some transforms
+        int seen = 0;
+        for (int i = 0; i < orbit_size && !seen; i++) {
+            seen = memcmp(&orbit[i * n], variant, n * sizeof(int)) == 0;
+        }
+        if (!seen) {
+            transform_of[orbit_size++] = t;
+        }
+    }
+    
+    // --limit may fall in the middle of an orbit
+    for (int i = 0; i < orbit_size && !(solution_limit > 0 && solutions_count >= solution_limit); i++) {
+        solutions_count++;
+        if (i == 0) {
+            printf("\n═══════════════════════════════════════════════════════════\n");
+            printf("Solution #%d (UNIQUE #%d, orbit of %d)\n", solutions_count, unique_count, orbit_size);
+            printf("═══════════════════════════════════════════════════════════\n");
+        } else {
+            printf("\n───────────────────────────────────────────────────────────\n");
+            printf("Solution #%d (variant of Unique #%d, %s)\n", solutions_count, unique_count,
+                   symmetry_names[transform_of[i]]);
+            printf("───────────────────────────────────────────────────────────\n");
+        }
+        print_solution(&orbit[i * n], solutions_count);
+    }
+    
+    free(orbit);
+}
+
+/**
+ * Orbit mode: search only for canonical representatives, then expand each
+ * into its symmetry orbit instead of re-finding the variants in the search
+ */
+void solve_orbits(int row, int *temp) {
+    if (row == n) {
+        if (is_canonical_board(board, temp)) {
+            emit_orbit(board);
+            if ((solution_limit > 0 && solutions_count >= solution_limit) ||
+                (unique_limit > 0 && unique_count >= unique_limit)) {
+                stop_search = 1;
+            }
+        }
+        return;
+    }
+    
+    for (int col = 0; col < n && !stop_search; col++) {
+        if (is_canonical_prefix(row, col) && is_safe(row, col)) {
+            board[row] = col;
+            solve_orbits(row + 1, temp);
+        }
+    }
+}
+
+/**
+ * Build one solution directly using the explicit construction for N >= 4:
+ * even columns then odd columns, with adjustments when N mod 6 is 2 or 3
+ * Returns 1 on success, 0 if no solution exists for this N (2 and 3)
+ */
+int construct_solution(int *b) {
+    if (n == 1) {
+        b[0] = 0;
+        return 1;
+    }
+    if (n < 4) {
+        return 0;
+    }
+    
+    int row = 0;
+    int rem = n % 6;
+    
+    // Even columns (1-based): 2, 4, 6, ... with 2 moved to the end when N mod 6 == 3
+    if (rem == 3) {
+        for (int col = 4; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+        b[row++] = 1;
+    } else {
+        for (int col = 2; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+    }
+    
+    // Odd columns (1-based): 1, 3, 5, ... reordered when N mod 6 is 2 or 3
+    if (rem == 2) {
+        b[row++] = 2;
+        b[row++] = 0;
+        for (int col = 7; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+        b[row++] = 4;
+    } else if (rem == 3) {
+        for (int col = 5; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+        b[row++] = 0;
+        b[row++] = 2;
+    } else {
+        for (int col = 1; col <= n; col += 2) {
+            b[row++] = col - 1;
+        }
+    }
+    return 1;
+}
+
 int main(int argc, char *argv[]) {
     n = 8;
     
-    if (argc > 1) {
-        n = atoi(argv[1]);
-        if (n < 1) {
-            fprintf(stderr, "Error: N must be at least 1\n");
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--limit") == 0 || strcmp(argv[i], "--limit-unique") == 0) {
+            if (i + 1 < argc) {
+                int *target = (strcmp(argv[i], "--limit") == 0) ? &solution_limit : &unique_limit;
+                *target = atoi(argv[++i]);
+                if (*target < 1) {
+                    fprintf(stderr, "Error: Limit must be at least 1\n");
+                    return 1;
+                }
+            } else {
+                fprintf(stderr, "Error: %s requires a number argument\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--first") == 0) {
+            solution_limit = 1;
+        } else if (strcmp(argv[i], "--construct") == 0) {
+            use_construct = 1;
+        } else if (strcmp(argv[i], "--orbits") == 0) {
+            emit_orbits = 1;
+        } else if (strcmp(argv[i], "--place") == 0 || strcmp(argv[i], "--block") == 0) {
+            int row, col;
+            if (i + 1 >= argc || !parse_cell(argv[i + 1], &row, &col)) {
+                fprintf(stderr, "Error: %s requires a ROW,COL argument\n", argv[i]);
+                return 1;
+            }
+            add_constraint(row, col, strcmp(argv[i], "--place") == 0);
+            i++;
+        } else if (strcmp(argv[i], "--constraints") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: --constraints requires a file argument\n");
+                return 1;
+            }
+            if (load_constraints_file(argv[++i]) != 0) {
+                return 1;
+            }
+        } else if (argv[i][0] != '-') {
+            n = atoi(argv[i]);
+            if (n < 1) {
+                fprintf(stderr, "Error: N must be at least 1\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            fprintf(stderr, "Usage: %s [N] [--limit K] [--limit-unique K] [--first] [--construct] [--orbits]\n"
+                            "          [--place ROW,COL] [--block ROW,COL] [--constraints FILE]\n", argv[0]);
             return 1;
         }
     }
     
+    // Reject mode conflicts before the n*n mask is allocated
+    if (num_constraints > 0 && use_construct) {
+        fprintf(stderr, "Error: --construct cannot be combined with --place/--block/--constraints\n");
+        return 1;
+    }
+    if (num_constraints > 0 && emit_orbits) {
+        // Constraints break the symmetry, so orbit members need not satisfy them
+        fprintf(stderr, "Error: --orbits cannot be combined with --place/--block/--constraints\n");
+        return 1;
+    }
+    if (build_allowed_mask() != 0) {
+        return 1;
+    }
+    
     board = (int *)malloc(n * sizeof(int));
     solution_set.capacity = 1000;
     solution_set.solutions = (char **)malloc(solution_set.capacity * sizeof(char *));
@@ -233,12 +568,55 @@ int main(int argc, char *argv[]) {
     printf("║  are counted as one unique solution                        ║\n");
     printf("╚════════════════════════════════════════════════════════════╝\n\n");
     
+    if (allowed) {
+        printf("Constraints: %d pre-placed queen(s), %d rule(s)\n\n", num_fixed_queens, num_constraints);
+    }
+    
+    if (use_construct) {
+        // Constructive fast path: a single witness without any search
+        clock_t start = clock();
+        int found = construct_solution(board);
+        clock_t end = clock();
+        double elapsed = (double)(end - start) / CLOCKS_PER_SEC;
+        
+        if (found) {
+            if (n <= 64) {
+                print_solution(board, 1);
+            } else {
+                // Too wide to draw, so give the column of each row's queen on one line
+                printf("\nSolution #1 (columns, row 0 first):\n");
+                for (int row = 0; row < n; row++) {
+                    printf(row ? " %d" : "%d", board[row]);
+                }
+                printf("\n");
+            }
+        }
+        printf("\nTime: %.6f seconds (%.1f microseconds)\n", elapsed, elapsed * 1e6);
+        printf("\n╔════════════════════════════════════════════════════════════╗\n");
+        printf("║ Constructed solution:           %-27s║\n", found ? "YES" : "NO (none exist)");
+        printf("╚════════════════════════════════════════════════════════════╝\n");
+        
+        free(solution_set.solutions);
+        free(solution_set.unique_ids);
+        free(board);
+        return found ? 0 : 1;
+    }
+    
     clock_t start = clock();
-    solve_nqueens(0);
+    if (emit_orbits) {
+        int *temp = (int *)malloc(n * sizeof(int));
+        solve_orbits(0, temp);
+        free(temp);
+    } else {
+        solve_nqueens(0);
+    }
     clock_t end = clock();
     double elapsed = (double)(end - start) / CLOCKS_PER_SEC;
     
     printf("Time: %.6f seconds\n", elapsed);
+    if (stop_search) {
+        printf("Requested limit reached: the search stopped there without checking for more solutions\n");
+    }
     
     printf("\n╔════════════════════════════════════════════════════════════╗\n");
     printf("║ Total solutions found:          %-27d║\n", solutions_count);
@@ -255,6 +633,8 @@ int main(int argc, char *argv[]) {
     }
     free(solution_set.solutions);
     free(solution_set.unique_ids);
+    free(constraints);
+    free(allowed);
     free(board);
     
     return 0;